@@ -0,0 +1,273 @@
+#include <libnotify/notify.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alert.h"
+#include "osd.h"
+#include "sound.h"
+#include "trace.h"
+
+typedef enum {
+    ALERT_JOB_WAITING,
+    ALERT_JOB_FIRED,
+    ALERT_JOB_CANCELLED
+} alert_job_state_t;
+
+// prepare runs as soon as the thread starts. A fired job calls fire when
+// prepare succeeded and fallback (the whole unprepared path) when it failed,
+// so a busy device or missing display at arm time never drops the alert.
+// release always runs last and frees ctx
+typedef struct {
+    const char *name;
+    int (*prepare)(void *ctx);
+    void (*fire)(void *ctx, uint64_t deadline_ns);
+    void (*fallback)(void *ctx);
+    void (*release)(void *ctx);
+} alert_job_ops_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    alert_job_state_t state;
+    uint64_t deadline_ns;
+    const alert_job_ops_t *ops;
+    void *ctx;
+} alert_job_t;
+
+typedef struct {
+    sound_play_data_t data;
+    sound_prepared_t prepared;
+} alert_sound_t;
+
+typedef struct {
+    char *text;
+    int duration;
+    int all_monitors;
+    int created;
+    osd_overlays_t overlays;
+} alert_osd_t;
+
+static int armed;
+static int alert_headless;
+static uint64_t alert_deadline_ns;
+static alert_job_t *alert_sound;
+static alert_job_t *alert_osd;
+static int alert_sound_fallback;
+static sound_play_data_t alert_sound_data;
+static NotifyNotification *alert_notification;
+
+static void *alert_job_thread(void *arg) {
+    alert_job_t *job = (alert_job_t*) arg;
+
+    trace_set_thread_name(job->ops->name);
+    int prepared = job->ops->prepare(job->ctx) == 0;
+
+    pthread_mutex_lock(&job->lock);
+    while (job->state == ALERT_JOB_WAITING)
+        pthread_cond_wait(&job->cond, &job->lock);
+    int fired = job->state == ALERT_JOB_FIRED;
+    pthread_mutex_unlock(&job->lock);
+
+    if (fired && prepared) job->ops->fire(job->ctx, job->deadline_ns);
+    else if (fired) job->ops->fallback(job->ctx);
+    job->ops->release(job->ctx);
+
+    pthread_mutex_destroy(&job->lock);
+    pthread_cond_destroy(&job->cond);
+    free(job);
+    return NULL;
+}
+
+// ctx belongs to the job from here, it is released even when the thread can't start
+static alert_job_t *alert_job_start(const alert_job_ops_t *ops, void *ctx) {
+    pthread_t thread;
+    alert_job_t *job = (alert_job_t*) calloc(1, sizeof(alert_job_t));
+    if (!job) {
+        ops->release(ctx);
+        return NULL;
+    }
+
+    job->ops = ops;
+    job->ctx = ctx;
+    job->state = ALERT_JOB_WAITING;
+    pthread_mutex_init(&job->lock, NULL);
+    pthread_cond_init(&job->cond, NULL);
+
+    if (pthread_create(&thread, NULL, alert_job_thread, job) != 0) {
+        pthread_mutex_destroy(&job->lock);
+        pthread_cond_destroy(&job->cond);
+        free(job);
+        ops->release(ctx);
+        return NULL;
+    }
+    pthread_detach(thread);
+    return job;
+}
+
+static void alert_job_signal(alert_job_t *job, alert_job_state_t state, uint64_t deadline_ns) {
+    pthread_mutex_lock(&job->lock);
+    job->deadline_ns = deadline_ns;
+    job->state = state;
+    pthread_cond_signal(&job->cond);
+    pthread_mutex_unlock(&job->lock);
+}
+
+static int alert_sound_prepare(void *ctx) {
+    alert_sound_t *sound = (alert_sound_t*) ctx;
+    return sound_open(&sound->data, &sound->prepared);
+}
+
+static void alert_sound_fire(void *ctx, uint64_t deadline_ns) {
+    alert_sound_t *sound = (alert_sound_t*) ctx;
+    if (trace_enabled) trace_record("alert:deadline_to_audio", deadline_ns, trace_now());
+    sound_play_prepared(&sound->prepared);
+}
+
+// what sound_play_async would do, already on a thread of its own
+static void alert_sound_fallback_play(void *ctx) {
+    alert_sound_t *sound = (alert_sound_t*) ctx;
+    sound_close(&sound->prepared);
+    sound_play(&sound->data);
+}
+
+static void alert_sound_release(void *ctx) {
+    alert_sound_t *sound = (alert_sound_t*) ctx;
+    sound_close(&sound->prepared);
+    free(sound);
+    sound_unref();
+}
+
+static const alert_job_ops_t alert_sound_ops = {
+    "sound", alert_sound_prepare, alert_sound_fire, alert_sound_fallback_play, alert_sound_release
+};
+
+static int alert_osd_prepare(void *ctx) {
+    alert_osd_t *osd = (alert_osd_t*) ctx;
+    TRACE_BEGIN(span);
+    osd->created = osd_overlays_create(&osd->overlays, osd->text, osd->all_monitors) == 0;
+    TRACE_END(span, "osd:prepare");
+    return osd->created ? 0 : 1;
+}
+
+static void alert_osd_fire(void *ctx, uint64_t deadline_ns) {
+    alert_osd_t *osd = (alert_osd_t*) ctx;
+    // ends once the map requests have been sent, the compositor's frame is not observable here
+    osd_overlays_map(&osd->overlays);
+    if (trace_enabled) trace_record("alert:deadline_to_first_frame", deadline_ns, trace_now());
+    osd_overlays_run(&osd->overlays, osd->duration);
+}
+
+static void alert_osd_fallback_run(void *ctx) {
+    alert_osd_t *osd = (alert_osd_t*) ctx;
+    osd_run(osd->text, osd->duration, osd->all_monitors);
+}
+
+static void alert_osd_release(void *ctx) {
+    alert_osd_t *osd = (alert_osd_t*) ctx;
+    if (osd->created) osd_overlays_destroy(&osd->overlays);
+    free(osd->text);
+    free(osd);
+}
+
+static const alert_job_ops_t alert_osd_ops = {
+    "osd", alert_osd_prepare, alert_osd_fire, alert_osd_fallback_run, alert_osd_release
+};
+
+static int alert_osd_headless_prepare(void *ctx) {
+    return 0;
+}
+
+static void alert_osd_headless_fire(void *ctx, uint64_t deadline_ns) {
+}
+
+static void alert_osd_headless_fallback(void *ctx) {
+}
+
+// the job runs through every state, only the overlay windows are left out
+static const alert_job_ops_t alert_osd_headless_ops = {
+    "osd", alert_osd_headless_prepare, alert_osd_headless_fire, alert_osd_headless_fallback, alert_osd_release
+};
+
+// the sound and OSD threads get their device, sample and windows ready
+// and then wait, so firing is only a signal to each of them
+int alert_arm(const alert_t *alert, uint64_t deadline_ns) {
+    TRACE_BEGIN(span);
+    int res = 0;
+    alert_disarm();
+
+    if (alert->volume > 0) {
+        alert_sound_t *sound = (alert_sound_t*) calloc(1, sizeof(alert_sound_t));
+        alert_sound_data.audio_file = alert->audio_file;
+        alert_sound_data.volume = alert->volume;
+        if (sound) {
+            sound->data = alert_sound_data;
+            sound_ref();
+            alert_sound = alert_job_start(&alert_sound_ops, sound);
+        }
+        // a ding that can't be prepared is played the old way when fired
+        alert_sound_fallback = alert_sound == NULL;
+        if (alert_sound_fallback) res = 1;
+    }
+
+    alert_osd_t *osd = (alert_osd_t*) calloc(1, sizeof(alert_osd_t));
+    if (osd && (osd->text = strdup(alert->message))) {
+        osd->duration = alert->osd_duration;
+        osd->all_monitors = alert->osd_all_monitors;
+        alert_osd = alert_job_start(alert->headless ? &alert_osd_headless_ops : &alert_osd_ops, osd);
+    } else {
+        free(osd);
+    }
+    if (!alert_osd) res = 1;
+
+    alert_notification = notify_notification_new(alert->title, alert->message, NULL);
+    notify_notification_set_timeout(alert_notification, alert->notification_delay * 1000);
+
+    alert_deadline_ns = deadline_ns;
+    alert_headless = alert->headless;
+    armed = 1;
+    TRACE_END(span, "alert:arm");
+    return res;
+}
+
+void alert_fire() {
+    if (!armed) return;
+    TRACE_BEGIN(span);
+
+    // audio and overlay first, showing the notification is a D-Bus round trip
+    if (alert_sound) alert_job_signal(alert_sound, ALERT_JOB_FIRED, alert_deadline_ns);
+    else if (alert_sound_fallback) sound_play_async(&alert_sound_data);
+    if (alert_osd) alert_job_signal(alert_osd, ALERT_JOB_FIRED, alert_deadline_ns);
+    alert_sound = NULL;
+    alert_osd = NULL;
+    alert_sound_fallback = 0;
+
+    if (alert_notification) {
+        if (!alert_headless) notify_notification_show(alert_notification, NULL);
+        g_object_unref(G_OBJECT(alert_notification));
+        alert_notification = NULL;
+    }
+
+    armed = 0;
+    TRACE_END(span, "alert:fire");
+}
+
+void alert_disarm() {
+    if (!armed) return;
+
+    if (alert_sound) alert_job_signal(alert_sound, ALERT_JOB_CANCELLED, 0);
+    if (alert_osd) alert_job_signal(alert_osd, ALERT_JOB_CANCELLED, 0);
+    alert_sound = NULL;
+    alert_osd = NULL;
+    alert_sound_fallback = 0;
+
+    if (alert_notification) {
+        g_object_unref(G_OBJECT(alert_notification));
+        alert_notification = NULL;
+    }
+
+    armed = 0;
+}
+
+int alert_armed() {
+    return armed;
+}
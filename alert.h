@@ -0,0 +1,27 @@
+#ifndef FOSSODORO_ALERT_H
+#define FOSSODORO_ALERT_H
+
+#include <stdint.h>
+
+#ifndef ALERT_PREARM_SECONDS
+#define ALERT_PREARM_SECONDS 3 // how long before the deadline the alert resources are warmed up
+#endif
+
+typedef struct {
+    const char *title;
+    const char *message;
+    const char *audio_file;
+    double volume;
+    int notification_delay;
+    int osd_duration;
+    int osd_all_monitors;
+    int headless;           // soak runs: jobs and notification are built and fired, nothing is shown
+} alert_t;
+
+// returns non-zero when a part couldn't be prepared, a missing ding is still played when fired
+int alert_arm(const alert_t *alert, uint64_t deadline_ns);
+void alert_fire();
+void alert_disarm();
+int alert_armed();
+
+#endif // FOSSODORO_ALERT_H
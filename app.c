@@ -0,0 +1,120 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "app.h"
+
+AppData app = {0};
+
+static char *config_path;
+
+const char* select_icon() {
+    int val = 0, duration = 0;
+    if(app.timer_active) {
+        if(app.timer_paused) return ICON_PAUSE;
+
+        duration = (app.current_mode == MODE_POMODORO ? app.pomodoro_duration :
+        app.current_mode == MODE_SHORT_BREAK ? app.break_duration : app.long_break_duration);
+
+        val = app.remaining_seconds * 100 / duration;
+        if(val > 90) return ICON_100;
+        if(val > 80) return ICON_090;
+        if(val > 70) return ICON_080;
+        if(val > 60) return ICON_070;
+        if(val > 50) return ICON_060;
+        if(val > 40) return ICON_050;
+        if(val > 30) return ICON_040;
+        if(val > 20) return ICON_030;
+        if(val > 10) return ICON_020;
+        if(val > 5) return ICON_010;
+        return ICON_000;
+    } else {
+        return DEFAULT_ICON;
+    }
+}
+
+char *get_config_path() {
+    if(config_path != NULL) return config_path;
+    const char *home = (char*)g_get_home_dir(); const char *cfg = "/.config/";
+    int cp_len = (strlen(home) + strlen(cfg) + strlen(CONFIG_FILE)) + 1;
+    config_path = (char*) malloc(cp_len + sizeof(char));
+    sprintf(config_path, "%s%s%s", home, cfg, CONFIG_FILE);
+    return config_path;
+}
+
+void set_config_path(const char *path) {
+    free(config_path);
+    config_path = path ? strdup(path) : NULL;
+}
+
+void load_config() {
+    // newer settings than most config files, an empty hotkey disables it
+    g_strlcpy(app.hotkey_play_pause, DEFAULT_HOTKEY_PLAY_PAUSE, HOTKEY_LEN);
+    g_strlcpy(app.hotkey_stop, DEFAULT_HOTKEY_STOP, HOTKEY_LEN);
+    app.idle_timeout = DEFAULT_IDLE_TIMEOUT;
+
+    FILE *f = fopen(get_config_path(), "r");
+    if (!f) {
+        app.pomodoro_duration       = 25 * 60;
+        app.break_duration          = 5 * 60;
+        app.long_break_duration     = 15 * 60;
+        app.pomodoros_before_long   = 4;
+        app.volume_level            = 100;
+        app.notification_delay      = 10;
+        return;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n')
+            continue;
+        char key[128], str_value[HOTKEY_LEN] = "";
+        int value;
+        if (sscanf(line, "%127[^=]=%63[^\n]", key, str_value) >= 1) {
+            if (strcmp(key, "hotkey_play_pause") == 0)
+                g_strlcpy(app.hotkey_play_pause, str_value, HOTKEY_LEN);
+            else if (strcmp(key, "hotkey_stop") == 0)
+                g_strlcpy(app.hotkey_stop, str_value, HOTKEY_LEN);
+        }
+        if (sscanf(line, "%127[^=]=%d", key, &value) == 2) {
+            if (strcmp(key, "pomodoro_duration") == 0)
+                app.pomodoro_duration = value * 60;
+            else if (strcmp(key, "break_duration") == 0)
+                app.break_duration = value * 60;
+            else if (strcmp(key, "long_break_duration") == 0)
+                app.long_break_duration = value * 60;
+            else if (strcmp(key, "pomodoros_before_long") == 0)
+                app.pomodoros_before_long = value;
+            else if (strcmp(key, "volume_level") == 0)
+                app.volume_level = value;
+            else if (strcmp(key, "notification_delay") == 0)
+                app.notification_delay = value;
+            else if (strcmp(key, "osd_all_monitors") == 0)
+                app.osd_all_monitors = value != 0;
+            else if (strcmp(key, "idle_timeout") == 0)
+                app.idle_timeout = value;
+            else if (strcmp(key, "idle_resume_ask") == 0)
+                app.idle_resume_ask = value != 0;
+            else if (strcmp(key, "countdown_seconds") == 0)
+                app.countdown_seconds = value;
+        }
+    }
+    fclose(f);
+}
+
+void save_config() {
+    FILE *f = fopen(get_config_path(), "w");
+    if (!f)
+        return;
+    fprintf(f, "pomodoro_duration=%d\n", app.pomodoro_duration / 60);
+    fprintf(f, "break_duration=%d\n", app.break_duration / 60);
+    fprintf(f, "long_break_duration=%d\n", app.long_break_duration / 60);
+    fprintf(f, "pomodoros_before_long=%d\n", app.pomodoros_before_long);
+    fprintf(f, "volume_level=%d\n", app.volume_level);
+    fprintf(f, "notification_delay=%d\n", app.notification_delay);
+    fprintf(f, "osd_all_monitors=%d\n", app.osd_all_monitors);
+    fprintf(f, "idle_timeout=%d\n", app.idle_timeout);
+    fprintf(f, "idle_resume_ask=%d\n", app.idle_resume_ask);
+    fprintf(f, "countdown_seconds=%d\n", app.countdown_seconds);
+    fprintf(f, "hotkey_play_pause=%s\n", app.hotkey_play_pause);
+    fprintf(f, "hotkey_stop=%s\n", app.hotkey_stop);
+    fclose(f);
+}
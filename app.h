@@ -0,0 +1,87 @@
+#ifndef FOSSODORO_APP_H
+#define FOSSODORO_APP_H
+
+#include <glib.h>
+
+#ifndef DATADIR
+#define DATADIR                 "../share/fossodoro/"
+#endif
+
+#define DEFAULT_ICON            DATADIR "icons/100.svg"
+#define ICON_100                DATADIR "icons/100.svg"
+#define ICON_090                DATADIR "icons/90.svg"
+#define ICON_080                DATADIR "icons/80.svg"
+#define ICON_070                DATADIR "icons/70.svg"
+#define ICON_060                DATADIR "icons/60.svg"
+#define ICON_050                DATADIR "icons/50.svg"
+#define ICON_040                DATADIR "icons/40.svg"
+#define ICON_030                DATADIR "icons/30.svg"
+#define ICON_020                DATADIR "icons/20.svg"
+#define ICON_010                DATADIR "icons/10.svg"
+#define ICON_000                DATADIR "icons/0.svg"
+#define ICON_OFF                DATADIR "icons/off.svg"
+#define ICON_BREAK              DATADIR "icons/break.svg"
+#define ICON_PLAY               DATADIR "icons/play.svg"
+#define ICON_PAUSE              DATADIR "icons/pause.svg"
+
+#define DEFAULT_DING_FILE       DATADIR "sounds/ding2.mp3"
+
+#define CONFIG_FILE             "fossodoro.cfg"
+
+#define DEFAULT_HOTKEY_PLAY_PAUSE   ""      // opt-in, a global grab would steal the key from every other client
+#define DEFAULT_HOTKEY_STOP         ""
+#define HOTKEY_LEN                  64
+
+#define DEFAULT_IDLE_TIMEOUT        0
+
+typedef enum {
+    MODE_POMODORO,
+    MODE_SHORT_BREAK,
+    MODE_LONG_BREAK
+} TimerMode;
+
+typedef enum {
+    POMO_ICON_0,
+    POMO_ICON_10,
+    POMO_ICON_20,
+    POMO_ICON_30,
+    POMO_ICON_40,
+    POMO_ICON_50,
+    POMO_ICON_60,
+    POMO_ICON_70,
+    POMO_ICON_80,
+    POMO_ICON_100,
+} T_Pomo_Icon;
+
+typedef struct {
+    guint            timer_id;
+    int              remaining_seconds;
+    int              pomodoro_duration;
+    int              break_duration;
+    int              long_break_duration;
+    int              pomodoros_before_long;
+    int              current_pomodoro_count;
+    TimerMode        current_mode;
+    gboolean         timer_active;
+    gboolean         timer_paused;
+    gboolean         always_on_top_enabled;
+    int              volume_level;
+    int              notification_delay;
+    gboolean         osd_all_monitors;
+    int              idle_timeout;
+    gboolean         idle_resume_ask;
+    int              countdown_seconds;
+    const char       *current_icon;
+    char             hotkey_play_pause[HOTKEY_LEN];
+    char             hotkey_stop[HOTKEY_LEN];
+} AppData;
+
+extern AppData app;
+
+const char* select_icon();
+char *get_config_path();
+void set_config_path(const char *path);
+void load_config();
+void save_config();
+
+#endif // FOSSODORO_APP_H
@@ -0,0 +1,226 @@
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "app.h"
+#include "osd.h"
+#include "sound.h"
+#include "trace.h"
+
+#define BENCH_DEFAULT_ITERATIONS    101
+#define BENCH_WARMUP_ITERATIONS     5
+
+typedef void (*bench_fn_t)(void *ctx);
+
+typedef struct {
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    osd_data_t data;
+} bench_render_t;
+
+typedef struct {
+    const char *audio_file;
+} bench_decode_t;
+
+static const char *bench_icons[] = {
+    ICON_100, ICON_090, ICON_080, ICON_070, ICON_060, ICON_050,
+    ICON_040, ICON_030, ICON_020, ICON_010, ICON_000,
+    ICON_BREAK, ICON_PAUSE, ICON_PLAY, ICON_OFF
+};
+
+static FILE *bench_out;
+static int bench_iterations = BENCH_DEFAULT_ITERATIONS;
+static volatile uintptr_t bench_sink;
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+// runs fn `inner` times per sample and reports per-call timings over all samples
+static void bench_run(const char *name, bench_fn_t fn, void *ctx, int inner) {
+    uint64_t *samples = (uint64_t*) malloc(bench_iterations * sizeof(uint64_t));
+    if (!samples) return;
+
+    for (int i = 0; i < BENCH_WARMUP_ITERATIONS; i++)
+        for (int j = 0; j < inner; j++)
+            fn(ctx);
+
+    double mean = 0;
+    for (int i = 0; i < bench_iterations; i++) {
+        uint64_t start = trace_now();
+        for (int j = 0; j < inner; j++)
+            fn(ctx);
+        samples[i] = (trace_now() - start) / inner;
+        mean += samples[i];
+    }
+    mean /= bench_iterations;
+
+    qsort(samples, bench_iterations, sizeof(uint64_t), compare_u64);
+    int p99 = (bench_iterations * 99) / 100;
+    if (p99 >= bench_iterations) p99 = bench_iterations - 1;
+
+    fprintf(bench_out,
+            "{\"name\":\"%s\",\"iterations\":%d,\"inner\":%d,\"unit\":\"ns\","
+            "\"min\":%llu,\"median\":%llu,\"p99\":%llu,\"max\":%llu,\"mean\":%.1f}\n",
+            name, bench_iterations, inner,
+            (unsigned long long) samples[0],
+            (unsigned long long) samples[bench_iterations / 2],
+            (unsigned long long) samples[p99],
+            (unsigned long long) samples[bench_iterations - 1],
+            mean);
+    fflush(bench_out);
+    free(samples);
+}
+
+static void bench_osd_render(void *ctx) {
+    bench_render_t *r = (bench_render_t*) ctx;
+    cairo_save(r->cr);
+    cairo_set_operator(r->cr, CAIRO_OPERATOR_CLEAR);
+    cairo_paint(r->cr);
+    cairo_restore(r->cr);
+    osd_render(r->cr, &r->data);
+    cairo_surface_flush(r->surface);
+}
+
+static void bench_osd_calculate_thickness(void *ctx) {
+    osd_data_t *data = (osd_data_t*) ctx;
+    data->width = 640 + (data->width + 1) % 7040;
+    data->height = 480 + (data->height + 3) % 3840;
+    bench_sink += osd_calculate_thickness(data);
+}
+
+static void bench_sound_decode(void *ctx) {
+    bench_decode_t *d = (bench_decode_t*) ctx;
+    sound_sample_t sample;
+    if (sound_decode(d->audio_file, 1.0, &sample) == 0) {
+        bench_sink += sample.size;
+        sound_sample_free(&sample);
+    }
+}
+
+static void bench_icon_rasterize(void *ctx) {
+    (void) ctx;
+    for (size_t i = 0; i < sizeof(bench_icons) / sizeof(bench_icons[0]); i++) {
+        GdkPixbuf *p_buf = gdk_pixbuf_new_from_file_at_size(bench_icons[i], 16, 16, NULL);
+        if (p_buf) {
+            bench_sink += (uintptr_t) gdk_pixbuf_get_width(p_buf);
+            g_object_unref(p_buf);
+        }
+    }
+}
+
+static void bench_select_icon(void *ctx) {
+    (void) ctx;
+    app.remaining_seconds = app.remaining_seconds > 0 ? app.remaining_seconds - 1 : app.pomodoro_duration;
+    bench_sink += (uintptr_t) select_icon();
+}
+
+static void bench_config_round_trip(void *ctx) {
+    (void) ctx;
+    save_config();
+    load_config();
+    bench_sink += app.pomodoro_duration;
+}
+
+static void run_render_benchmarks() {
+    static const int sizes[][2] = { { 1920, 1080 }, { 3840, 2160 }, { 7680, 4320 } };
+    char name[64];
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        bench_render_t r;
+        r.surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, sizes[i][0], sizes[i][1]);
+        if (cairo_surface_status(r.surface) != CAIRO_STATUS_SUCCESS) {
+            fprintf(stderr, "Unable to create %dx%d surface\n", sizes[i][0], sizes[i][1]);
+            cairo_surface_destroy(r.surface);
+            continue;
+        }
+        r.cr = cairo_create(r.surface);
+        r.data.width = sizes[i][0];
+        r.data.height = sizes[i][1];
+        r.data.text = "Pomodoro session ended!";
+        osd_calculate_thickness(&r.data);
+
+        snprintf(name, sizeof(name), "osd_render/%dx%d", sizes[i][0], sizes[i][1]);
+        bench_run(name, bench_osd_render, &r, 1);
+
+        cairo_destroy(r.cr);
+        cairo_surface_destroy(r.surface);
+    }
+
+    osd_data_t data = { 0 };
+    bench_run("osd_calculate_thickness", bench_osd_calculate_thickness, &data, 100000);
+}
+
+static void run_sound_benchmarks() {
+    bench_decode_t d;
+
+    d.audio_file = DATADIR "sounds/ding1.mp3";
+    bench_run("sound_decode/ding1.mp3", bench_sound_decode, &d, 1);
+
+    d.audio_file = DATADIR "sounds/ding2.mp3";
+    bench_run("sound_decode/ding2.mp3", bench_sound_decode, &d, 1);
+}
+
+static void run_icon_benchmarks() {
+    bench_run("icon_rasterize/16px", bench_icon_rasterize, NULL, 1);
+
+    app.pomodoro_duration = 25 * 60;
+    app.break_duration = 5 * 60;
+    app.long_break_duration = 15 * 60;
+    app.current_mode = MODE_POMODORO;
+    app.remaining_seconds = app.pomodoro_duration;
+    app.timer_active = TRUE;
+    app.timer_paused = FALSE;
+    bench_run("select_icon", bench_select_icon, NULL, 1000000);
+}
+
+static void run_config_benchmarks() {
+    char *path = g_build_filename(g_get_tmp_dir(), "fossodoro-bench.cfg", NULL);
+    set_config_path(path);
+
+    app.pomodoro_duration = 25 * 60;
+    app.break_duration = 5 * 60;
+    app.long_break_duration = 15 * 60;
+    app.pomodoros_before_long = 4;
+    app.volume_level = 100;
+    app.notification_delay = 10;
+    bench_run("config_round_trip", bench_config_round_trip, NULL, 10);
+
+    remove(path);
+    set_config_path(NULL);
+    g_free(path);
+}
+
+int main(int argc, char *argv[]) {
+    const char *filter = NULL;
+    bench_out = stdout;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--iterations=", 13) == 0) {
+            bench_iterations = atoi(argv[i] + 13);
+        } else if (strncmp(argv[i], "--output=", 9) == 0) {
+            bench_out = fopen(argv[i] + 9, "w");
+            if (!bench_out) {
+                fprintf(stderr, "Unable to open %s\n", argv[i] + 9);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--filter=", 9) == 0) {
+            filter = argv[i] + 9;
+        } else {
+            fprintf(stderr, "usage: %s [--iterations=N] [--output=FILE] [--filter=render|sound|icon|config]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (bench_iterations < 1) bench_iterations = BENCH_DEFAULT_ITERATIONS;
+    sound_init();
+
+    if (!filter || strcmp(filter, "render") == 0) run_render_benchmarks();
+    if (!filter || strcmp(filter, "sound") == 0) run_sound_benchmarks();
+    if (!filter || strcmp(filter, "icon") == 0) run_icon_benchmarks();
+    if (!filter || strcmp(filter, "config") == 0) run_config_benchmarks();
+
+    sound_shutdown();
+    if (bench_out != stdout) fclose(bench_out);
+    return 0;
+}
@@ -0,0 +1,288 @@
+#include <gtk/gtk.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "countdown.h"
+#include "osd.h"
+#include "trace.h"
+
+#define COUNTDOWN_DIGITS        10
+
+typedef struct {
+    unsigned long frames;
+    unsigned long dropped;
+    gint64 frame_us_total;
+    gint64 frame_us_max;
+    unsigned long draws;
+    gint64 draw_us_total;
+    gint64 draw_us_max;
+} countdown_stats_t;
+
+static GtkWidget *countdown_window;
+static guint countdown_tick_id;
+static gint64 countdown_deadline;
+static gint64 countdown_total;
+static gint64 countdown_last_frame;
+static int countdown_width;
+static int countdown_height;
+static int countdown_thickness;
+static double countdown_length;
+static int countdown_value;
+static countdown_stats_t countdown_stats;
+
+// digits are rendered once per size and blitted, so a new second never reshapes text
+static cairo_surface_t *countdown_glyphs[COUNTDOWN_DIGITS];
+static int glyph_width;
+static int glyph_height;
+static int glyph_thickness;
+
+static void countdown_build_glyphs(int thickness) {
+    cairo_font_extents_t font_extents;
+    cairo_text_extents_t extents;
+    char digit[2] = "0";
+    double max_advance = 0;
+
+    if (glyph_thickness == thickness && countdown_glyphs[0]) return;
+
+    for (int i = 0; i < COUNTDOWN_DIGITS; i++) {
+        if (countdown_glyphs[i]) cairo_surface_destroy(countdown_glyphs[i]);
+        countdown_glyphs[i] = NULL;
+    }
+
+    cairo_surface_t *scratch = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
+    cairo_t *cr = cairo_create(scratch);
+    cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+    cairo_set_font_size(cr, 10 * thickness);
+    cairo_font_extents(cr, &font_extents);
+    for (int i = 0; i < COUNTDOWN_DIGITS; i++) {
+        digit[0] = '0' + i;
+        cairo_text_extents(cr, digit, &extents);
+        if (extents.x_advance > max_advance) max_advance = extents.x_advance;
+    }
+    cairo_destroy(cr);
+    cairo_surface_destroy(scratch);
+
+    glyph_width = (int) ceil(max_advance);
+    glyph_height = (int) ceil(font_extents.ascent + font_extents.descent);
+    glyph_thickness = thickness;
+
+    for (int i = 0; i < COUNTDOWN_DIGITS; i++) {
+        digit[0] = '0' + i;
+        countdown_glyphs[i] = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, glyph_width, glyph_height);
+        cr = cairo_create(countdown_glyphs[i]);
+        cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+        cairo_set_font_size(cr, 10 * thickness);
+        cairo_set_source_rgba(cr, 1.0, 0.0, 0.0, 1);
+        cairo_text_extents(cr, digit, &extents);
+        cairo_move_to(cr, (glyph_width - extents.x_advance) / 2, font_extents.ascent);
+        cairo_show_text(cr, digit);
+        cairo_destroy(cr);
+        cairo_surface_flush(countdown_glyphs[i]);
+    }
+}
+
+static GdkRectangle countdown_text_rect(int value) {
+    GdkRectangle rect;
+    int digits = 1;
+    while (value >= 10) {
+        value /= 10;
+        digits++;
+    }
+    rect.width = digits * glyph_width;
+    rect.height = glyph_height;
+    rect.x = (countdown_width - rect.width) / 2;
+    rect.y = (countdown_height - rect.height) / 2;
+    return rect;
+}
+
+// the border is a path walked clockwise from the top-left corner, returns the
+// rectangles covering the part between perimeter positions from and to
+static int countdown_segments(double from, double to, GdkRectangle *rects) {
+    double w = countdown_width, h = countdown_height, t = countdown_thickness;
+    double edges[5] = { 0, w, w + h, 2 * w + h, 2 * w + 2 * h };
+    int n = 0;
+
+    for (int e = 0; e < 4; e++) {
+        double s0 = (from > edges[e] ? from : edges[e]) - edges[e];
+        double s1 = (to < edges[e + 1] ? to : edges[e + 1]) - edges[e];
+        double x, y, rw, rh;
+        if (s1 <= s0) continue;
+
+        switch (e) {
+            case 0: x = s0;     y = 0;      rw = s1 - s0;   rh = t;         break;
+            case 1: x = w - t;  y = s0;     rw = t;         rh = s1 - s0;   break;
+            case 2: x = w - s1; y = h - t;  rw = s1 - s0;   rh = t;         break;
+            default: x = 0;     y = h - s1; rw = t;         rh = s1 - s0;   break;
+        }
+        rects[n].x = (int) floor(x);
+        rects[n].y = (int) floor(y);
+        rects[n].width = (int) ceil(x + rw) - rects[n].x;
+        rects[n].height = (int) ceil(y + rh) - rects[n].y;
+        n++;
+    }
+    return n;
+}
+
+static void countdown_queue_rect(GdkRectangle *rect) {
+    gtk_widget_queue_draw_area(countdown_window, rect->x, rect->y, rect->width, rect->height);
+}
+
+static gboolean countdown_draw(GtkWidget *widget, cairo_t *cr, gpointer user_data) {
+    TRACE_BEGIN(span);
+    gint64 start = g_get_monotonic_time();
+    GdkRectangle rects[4];
+    char text[16];
+
+    // GTK clips to the damaged area, so this only touches what changed
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_set_source_rgba(cr, 0, 0, 0, 0);
+    cairo_paint(cr);
+    cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+
+    cairo_set_source_rgba(cr, 1.0, 0.0, 0.0, 1);
+    int n = countdown_segments(0, countdown_length, rects);
+    for (int i = 0; i < n; i++)
+        cairo_rectangle(cr, rects[i].x, rects[i].y, rects[i].width, rects[i].height);
+    cairo_fill(cr);
+
+    GdkRectangle text_rect = countdown_text_rect(countdown_value);
+    snprintf(text, sizeof(text), "%d", countdown_value);
+    for (int i = 0; text[i]; i++) {
+        int x = text_rect.x + i * glyph_width;
+        cairo_set_source_surface(cr, countdown_glyphs[text[i] - '0'], x, text_rect.y);
+        cairo_rectangle(cr, x, text_rect.y, glyph_width, glyph_height);
+        cairo_fill(cr);
+    }
+
+    gint64 draw_us = g_get_monotonic_time() - start;
+    countdown_stats.draws++;
+    countdown_stats.draw_us_total += draw_us;
+    if (draw_us > countdown_stats.draw_us_max) countdown_stats.draw_us_max = draw_us;
+    TRACE_END(span, "countdown_draw");
+    return TRUE;
+}
+
+static void countdown_hide() {
+    gtk_widget_hide(countdown_window);
+
+    if (trace_enabled && countdown_stats.frames > 0 && countdown_stats.draws > 0) {
+        fprintf(stderr, "countdown: %lu frames, %lu dropped, frame avg %.2fms max %.2fms, draw avg %.2fms max %.2fms\n",
+                countdown_stats.frames, countdown_stats.dropped,
+                countdown_stats.frame_us_total / 1000.0 / countdown_stats.frames,
+                countdown_stats.frame_us_max / 1000.0,
+                countdown_stats.draw_us_total / 1000.0 / countdown_stats.draws,
+                countdown_stats.draw_us_max / 1000.0);
+    }
+}
+
+static gboolean countdown_tick(GtkWidget *widget, GdkFrameClock *clock, gpointer user_data) {
+    GdkRectangle rects[4];
+    gint64 refresh_interval = 0, presentation_time = 0;
+    gint64 frame_time = gdk_frame_clock_get_frame_time(clock);
+
+    gdk_frame_clock_get_refresh_info(clock, frame_time, &refresh_interval, &presentation_time);
+    if (countdown_last_frame) {
+        gint64 frame_us = frame_time - countdown_last_frame;
+        countdown_stats.frames++;
+        countdown_stats.frame_us_total += frame_us;
+        if (frame_us > countdown_stats.frame_us_max) countdown_stats.frame_us_max = frame_us;
+        if (refresh_interval > 0 && frame_us > refresh_interval * 3 / 2)
+            countdown_stats.dropped += (frame_us + refresh_interval / 2) / refresh_interval - 1;
+    }
+    countdown_last_frame = frame_time;
+
+    gint64 left = countdown_deadline - frame_time;
+    if (left <= 0) {
+        countdown_tick_id = 0;
+        countdown_hide();
+        return G_SOURCE_REMOVE;
+    }
+
+    double length = 2.0 * (countdown_width + countdown_height) * left / countdown_total;
+    if (length < countdown_length) {
+        int n = countdown_segments(length, countdown_length, rects);
+        for (int i = 0; i < n; i++)
+            countdown_queue_rect(&rects[i]);
+        countdown_length = length;
+    }
+
+    int value = (int) ((left + G_USEC_PER_SEC - 1) / G_USEC_PER_SEC);
+    if (value != countdown_value) {
+        GdkRectangle old_rect = countdown_text_rect(countdown_value);
+        GdkRectangle new_rect = countdown_text_rect(value);
+        countdown_queue_rect(&old_rect);
+        countdown_queue_rect(&new_rect);
+        countdown_value = value;
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+static void countdown_create_window(GdkScreen *screen) {
+    countdown_window = gtk_window_new(GTK_WINDOW_POPUP);
+    gtk_widget_set_visual(countdown_window, gdk_screen_get_rgba_visual(screen));
+    gtk_widget_set_app_paintable(countdown_window, TRUE);
+    gtk_window_set_accept_focus(GTK_WINDOW(countdown_window), FALSE);
+
+    // let every click go through to whatever is below
+    cairo_region_t *region = cairo_region_create();
+    gtk_widget_input_shape_combine_region(countdown_window, region);
+    cairo_region_destroy(region);
+
+    g_signal_connect(countdown_window, "draw", G_CALLBACK(countdown_draw), NULL);
+}
+
+// span_us is the whole countdown, so a restart after a pause resumes the border where it was
+int countdown_start(gint64 deadline_us, gint64 span_us) {
+    GdkScreen *screen = gdk_screen_get_default();
+    GdkDisplay *display = gdk_display_get_default();
+    GdkRectangle geometry;
+    int x = 0, y = 0;
+
+    countdown_stop();
+
+    // without a compositor the overlay would cover the monitor in black
+    if (!gdk_screen_is_composited(screen)) return 1;
+
+    gdk_device_get_position(gdk_seat_get_pointer(gdk_display_get_default_seat(display)), NULL, &x, &y);
+    GdkMonitor *monitor = gdk_display_get_monitor_at_point(display, x, y);
+    if (!monitor) return 1;
+    gdk_monitor_get_geometry(monitor, &geometry);
+
+    osd_data_t rects_data;
+    rects_data.width = geometry.width;
+    rects_data.height = geometry.height;
+    osd_calculate_thickness(&rects_data);
+
+    if (!countdown_window) countdown_create_window(screen);
+    countdown_build_glyphs(rects_data.thickness);
+
+    countdown_width = geometry.width;
+    countdown_height = geometry.height;
+    countdown_thickness = rects_data.thickness;
+    countdown_deadline = deadline_us;
+    gint64 left = deadline_us - g_get_monotonic_time();
+    if (left <= 0 || span_us <= 0) return 1;
+    countdown_total = span_us > left ? span_us : left;
+    countdown_length = 2.0 * (countdown_width + countdown_height) * left / countdown_total;
+    countdown_value = (int) ((left + G_USEC_PER_SEC - 1) / G_USEC_PER_SEC);
+    countdown_last_frame = 0;
+    memset(&countdown_stats, 0, sizeof(countdown_stats));
+
+    gtk_window_move(GTK_WINDOW(countdown_window), geometry.x, geometry.y);
+    gtk_window_resize(GTK_WINDOW(countdown_window), geometry.width, geometry.height);
+    gtk_widget_show(countdown_window);
+    countdown_tick_id = gtk_widget_add_tick_callback(countdown_window, countdown_tick, NULL, NULL);
+    return 0;
+}
+
+void countdown_stop() {
+    if (!countdown_tick_id) return;
+    gtk_widget_remove_tick_callback(countdown_window, countdown_tick_id);
+    countdown_tick_id = 0;
+    countdown_hide();
+}
+
+gboolean countdown_active() {
+    return countdown_tick_id != 0;
+}
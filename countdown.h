@@ -0,0 +1,10 @@
+#ifndef FOSSODORO_COUNTDOWN_H
+#define FOSSODORO_COUNTDOWN_H
+
+#include <glib.h>
+
+int countdown_start(gint64 deadline_us, gint64 span_us);
+void countdown_stop();
+gboolean countdown_active();
+
+#endif // FOSSODORO_COUNTDOWN_H
@@ -1,83 +1,28 @@
+#include <glib-unix.h>
 #include <gtk/gtk.h>
 #include <libnotify/notify.h>
-#include <pthread.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include "alert.h"
+#include "app.h"
+#include "countdown.h"
+#include "hotkeys.h"
+#include "idle.h"
 #include "osd.h"
 #include "sound.h"
-
-#ifndef DATADIR
-#define DATADIR                 "../share/fossodoro/"
+#include "trace.h"
+#ifdef FOSSODORO_SOAK
+#include "soak.h"
 #endif
 
 #define GETTEXT_PACKAGE         "fossodoro"
 #include <locale.h>
 #include <glib/gi18n.h>
 
-#define DEFAULT_ICON            DATADIR "icons/100.svg"
-#define ICON_100                DATADIR "icons/100.svg"
-#define ICON_090                DATADIR "icons/90.svg"
-#define ICON_080                DATADIR "icons/80.svg"
-#define ICON_070                DATADIR "icons/70.svg"
-#define ICON_060                DATADIR "icons/60.svg"
-#define ICON_050                DATADIR "icons/50.svg"
-#define ICON_040                DATADIR "icons/40.svg"
-#define ICON_030                DATADIR "icons/30.svg"
-#define ICON_020                DATADIR "icons/20.svg"
-#define ICON_010                DATADIR "icons/10.svg"
-#define ICON_000                DATADIR "icons/0.svg"
-#define ICON_OFF                DATADIR "icons/off.svg"
-#define ICON_BREAK              DATADIR "icons/break.svg"
-#define ICON_PLAY               DATADIR "icons/play.svg"
-#define ICON_PAUSE              DATADIR "icons/pause.svg"
-
-#define DEFAULT_DING_FILE       DATADIR "sounds/ding2.mp3"
-
-#define CONFIG_FILE             "fossodoro.cfg"
-
 #define ICON_SIZE               GTK_ICON_SIZE_SMALL_TOOLBAR
 
-typedef enum {
-    MODE_POMODORO,
-    MODE_SHORT_BREAK,
-    MODE_LONG_BREAK
-} TimerMode;
-
-typedef enum {
-    POMO_ICON_0,
-    POMO_ICON_10,
-    POMO_ICON_20,
-    POMO_ICON_30,
-    POMO_ICON_40,
-    POMO_ICON_50,
-    POMO_ICON_60,
-    POMO_ICON_70,
-    POMO_ICON_80,
-    POMO_ICON_100,
-} T_Pomo_Icon;
-
-typedef struct {
-    guint            timer_id;
-    int              remaining_seconds;
-    int              pomodoro_duration;
-    int              break_duration;
-    int              long_break_duration;
-    int              pomodoros_before_long;
-    int              current_pomodoro_count;
-    TimerMode        current_mode;
-    gboolean         timer_active;
-    gboolean         timer_paused;
-    gboolean         always_on_top_enabled;
-    int              volume_level;
-    int              notification_delay;
-    const char       *current_icon;
-} AppData;
-
-static AppData app = {0};
-
-static char *config_path;
-
 
 GtkStatusIcon   *tray_icon;
 GtkWidget       *config_window;
@@ -87,6 +32,26 @@ GtkWidget       *always_on_top_label;
 GtkWidget       *always_on_top_chronometer;
 GtkWidget       *play_pause_button;
 GtkWidget       *stop_button;
+GtkWidget       *tray_menu;
+GtkWidget       *tray_start_item;
+GtkWidget       *tray_stop_item;
+
+// soak runs: the ding still plays (on the null driver) and the alert jobs
+// are armed and fired by the tick itself, nothing is shown
+static gboolean alerts_headless;
+static guint phase_deadline_id;
+static gint64 phase_deadline_us;
+static gboolean idle_paused;
+
+static uint64_t tray_menu_click_ns;
+#ifdef FOSSODORO_SOAK
+// reported in the soak summary
+static struct {
+    unsigned long count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} tray_menu_latency;
+#endif
 
 
 static gboolean timer_callback();
@@ -94,38 +59,11 @@ static void update_always_on_top_label();
 static void create_chronometer_floating_window();
 static void create_config_window();
 static void update_play_pause_icon();
+static void update_tray_menu();
+static void update_idle_watch();
 static gboolean on_always_on_top_button_press(GtkWidget *widget, GdkEventButton *event);
-static void load_config();
-static void save_config();
-static const char* select_icon();
 static void on_play_pause_button_clicked();
 static const char *get_current_mode_string();
-static char *get_config_path();
-
-static const char* select_icon() {
-    int val = 0, duration = 0; 
-    if(app.timer_active) {
-        if(app.timer_paused) return ICON_PAUSE;
-
-        duration = (app.current_mode == MODE_POMODORO ? app.pomodoro_duration :
-        app.current_mode == MODE_SHORT_BREAK ? app.break_duration : app.long_break_duration);
-
-        val = app.remaining_seconds * 100 / duration;
-        if(val > 90) return ICON_100;
-        if(val > 80) return ICON_090;
-        if(val > 70) return ICON_080;
-        if(val > 60) return ICON_070;
-        if(val > 50) return ICON_060;
-        if(val > 40) return ICON_050;
-        if(val > 30) return ICON_040;
-        if(val > 20) return ICON_030;
-        if(val > 10) return ICON_020;
-        if(val > 5) return ICON_010;
-        return ICON_000;
-    } else {
-        return DEFAULT_ICON;
-    }
-}
 
 static const char *get_current_mode_string() {
     switch(app.current_mode) {
@@ -138,81 +76,126 @@ static const char *get_current_mode_string() {
     }
 }
 
-static char *get_config_path() {
-    if(config_path != NULL) return config_path;
-    const char *home = (char*)g_get_home_dir(); const char *cfg = "/.config/";
-    int cp_len = (strlen(home) + strlen(cfg) + strlen(CONFIG_FILE)) + 1;
-    config_path = (char*) malloc(cp_len + sizeof(char));
-    sprintf(config_path, "%s%s%s", home, cfg, CONFIG_FILE);
-    return config_path;
-}
-
-static void load_config() {
-    FILE *f = fopen(get_config_path(), "r");
-    if (!f) {
-        app.pomodoro_duration       = 25 * 60;
-        app.break_duration          = 5 * 60;
-        app.long_break_duration     = 15 * 60;
-        app.pomodoros_before_long   = 4;
-        app.volume_level            = 100;
-        app.notification_delay      = 10;
-        return;
-    }
-    char line[256];
-    while (fgets(line, sizeof(line), f)) {
-        if (line[0] == '#' || line[0] == '\n')
-            continue;
-        char key[128];
-        int value;
-        if (sscanf(line, "%127[^=]=%d", key, &value) == 2) {
-            if (strcmp(key, "pomodoro_duration") == 0)
-                app.pomodoro_duration = value * 60;
-            else if (strcmp(key, "break_duration") == 0)
-                app.break_duration = value * 60;
-            else if (strcmp(key, "long_break_duration") == 0)
-                app.long_break_duration = value * 60;
-            else if (strcmp(key, "pomodoros_before_long") == 0)
-                app.pomodoros_before_long = value;
-            else if (strcmp(key, "volume_level") == 0)
-                app.volume_level = value;
-            else if (strcmp(key, "notification_delay") == 0)
-                app.notification_delay = value;
-        }
-    }
-    fclose(f);
-}
-
-static void save_config() {
-    FILE *f = fopen(get_config_path(), "w");
-    if (!f)
-        return;
-    fprintf(f, "pomodoro_duration=%d\n", app.pomodoro_duration / 60);
-    fprintf(f, "break_duration=%d\n", app.break_duration / 60);
-    fprintf(f, "long_break_duration=%d\n", app.long_break_duration / 60);
-    fprintf(f, "pomodoros_before_long=%d\n", app.pomodoros_before_long);
-    fprintf(f, "volume_level=%d\n", app.volume_level);
-    fprintf(f, "notification_delay=%d\n", app.notification_delay);
-    fclose(f);
-}
-
 static void show_notification(const char *title, const char *message) {
+    TRACE_BEGIN(span);
     NotifyNotification *notification = notify_notification_new(title, message, NULL);
     notify_notification_set_timeout(notification, app.notification_delay * 1000);
     notify_notification_show(notification, NULL);
     g_object_unref(G_OBJECT(notification));
+    TRACE_END(span, "show_notification");
 
-    osd_run(message, 2);
+    osd_run(message, 2, app.osd_all_monitors);
 }
 
 static void update_application_icon() {
+    TRACE_BEGIN(span);
     const char *icon = select_icon();
     if(strcmp(icon, app.current_icon) != 0) {
         app.current_icon = icon;
         gtk_status_icon_set_from_file(tray_icon, app.current_icon);
     }
+    TRACE_END(span, "update_application_icon");
+}
+
+static const char *get_phase_end_message() {
+    if (app.current_mode == MODE_POMODORO)
+        return _("Pomodoro session ended!");
+    return _("Break ended! Unpause to continue.");
+}
+
+// fixed the first time the countdown or the alerts need it, cleared on pause and at the end
+static gint64 get_phase_deadline() {
+    if (!phase_deadline_us)
+        phase_deadline_us = g_get_monotonic_time() + (gint64) app.remaining_seconds * G_USEC_PER_SEC;
+    return phase_deadline_us;
+}
+
+static void end_phase() {
+    if (alert_armed()) {
+        alert_fire();
+    } else {
+        if (app.volume_level > 0) {
+            sound_play_data_t sound_play_data;
+            sound_play_data.audio_file = DEFAULT_DING_FILE;
+            sound_play_data.volume = app.volume_level / 100.0;
+            sound_play_async(&sound_play_data);
+        }
+        if (!alerts_headless)
+            show_notification(_("Pomodoro Timer"), get_phase_end_message());
+    }
+    phase_deadline_us = 0;
+
+    if (app.current_mode == MODE_POMODORO) {
+        app.current_pomodoro_count++;
+        if (app.current_pomodoro_count >= app.pomodoros_before_long) {
+            app.current_mode = MODE_LONG_BREAK;
+            app.remaining_seconds = app.long_break_duration;
+            app.current_pomodoro_count = 0;
+        } else {
+            app.current_mode = MODE_SHORT_BREAK;
+            app.remaining_seconds = app.break_duration;
+        }
+    } else {
+        app.current_mode = MODE_POMODORO;
+        app.remaining_seconds = app.pomodoro_duration;
+        if(!app.timer_paused)
+            on_play_pause_button_clicked();
+    }
+    update_idle_watch();
+}
+
+static gboolean on_phase_deadline() {
+    TRACE_BEGIN(span);
+    phase_deadline_id = 0;
+    end_phase();
+
+    // count the new phase from the deadline instead of the old tick phase, a
+    // plain timeout since g_timeout_add_seconds snaps to GLib's own second boundary
+    if (app.timer_active && !app.timer_paused && app.timer_id) {
+        g_source_remove(app.timer_id);
+        app.timer_id = g_timeout_add(1000, timer_callback, NULL);
+    }
+
+    if (app.always_on_top_enabled && always_on_top_chronometer)
+        update_always_on_top_label();
+    update_application_icon();
+
+    TRACE_END(span, "phase_deadline");
+    return FALSE;
+}
+
+static void arm_phase_end() {
+    alert_t alert;
+    alert.title = _("Pomodoro Timer");
+    alert.message = get_phase_end_message();
+    alert.audio_file = DEFAULT_DING_FILE;
+    alert.volume = app.volume_level / 100.0;
+    alert.notification_delay = app.notification_delay;
+    alert.osd_duration = 2;
+    alert.osd_all_monitors = app.osd_all_monitors;
+    alert.headless = alerts_headless;
+
+    gint64 deadline = get_phase_deadline();
+    gint64 delay_ms = (deadline - g_get_monotonic_time() + 999) / 1000;
+    if (delay_ms < 0) delay_ms = 0;
+
+    alert_arm(&alert, (uint64_t) deadline * 1000);
+    // a soak tick doesn't wait for real time, the tick that reaches zero fires it
+    if (!alerts_headless)
+        phase_deadline_id = g_timeout_add_full(G_PRIORITY_HIGH, (guint) delay_ms, on_phase_deadline, NULL, NULL);
+}
+
+static void disarm_phase_end() {
+    if (phase_deadline_id) {
+        g_source_remove(phase_deadline_id);
+        phase_deadline_id = 0;
+    }
+    alert_disarm();
+    phase_deadline_us = 0;
 }
 
 static gboolean timer_callback() {
+    TRACE_BEGIN(span);
     if (app.remaining_seconds > 0)
         app.remaining_seconds--;
 
@@ -228,48 +211,30 @@ static gboolean timer_callback() {
 
     gtk_status_icon_set_tooltip_text(tray_icon, tooltip);
 
-    if (app.always_on_top_enabled && always_on_top_chronometer)
-        update_always_on_top_label();
+    // pausing closes the overlay, resuming inside the last seconds brings it back
+    if (app.countdown_seconds > 0 && app.remaining_seconds > 0 && app.remaining_seconds <= app.countdown_seconds &&
+        !countdown_active() && !alerts_headless)
+        countdown_start(get_phase_deadline(), (gint64) app.countdown_seconds * G_USEC_PER_SEC);
 
-    if (app.remaining_seconds < 1) {
+    // warm up sound, OSD and notification, the deadline callback fires them
+    if (!phase_deadline_id && !alert_armed() && app.remaining_seconds > 0 && app.remaining_seconds <= ALERT_PREARM_SECONDS)
+        arm_phase_end();
 
-        if (app.volume_level > 0) {
-            sound_play_data_t sound_play_data;
-            sound_play_data.audio_file = DEFAULT_DING_FILE;
-            sound_play_data.volume = app.volume_level / 100.0;
-            
-            pthread_t play_audio_thread;
-            pthread_create(&play_audio_thread, NULL, sound_play, &sound_play_data);
-        }
-
-        if (app.current_mode == MODE_POMODORO) {
-            show_notification(_("Pomodoro Timer"), _("Pomodoro session ended!"));
-
-            app.current_pomodoro_count++;
-            if (app.current_pomodoro_count >= app.pomodoros_before_long) {
-                app.current_mode = MODE_LONG_BREAK;
-                app.remaining_seconds = app.long_break_duration;
-                app.current_pomodoro_count = 0;
-            } else {
-                app.current_mode = MODE_SHORT_BREAK;
-                app.remaining_seconds = app.break_duration;
-            }
-        } else {
-            show_notification(_("Pomodoro Timer"), _("Break ended! Unpause to continue."));
+    if (app.always_on_top_enabled && always_on_top_chronometer)
+        update_always_on_top_label();
 
-            app.current_mode = MODE_POMODORO;
-            app.remaining_seconds = app.pomodoro_duration;
-            if(!app.timer_paused)
-                on_play_pause_button_clicked();
-        }
-    }
+    if (app.remaining_seconds < 1 && !phase_deadline_id)
+        end_phase();
 
     update_application_icon();
 
+    TRACE_END(span, "timer_callback");
     return TRUE;
 }
 
 static void update_always_on_top_label() {
+    static const char *current_img_path;
+    TRACE_BEGIN(span);
     char text[64], mode_str_label[64];
     int minutes = app.remaining_seconds / 60;
     int seconds = app.remaining_seconds % 60;
@@ -284,8 +249,13 @@ static void update_always_on_top_label() {
     gtk_label_set_text(GTK_LABEL(always_on_top_label), mode_str_label);
 
     const char *img_path = app.timer_active ? (app.timer_paused ? ICON_PAUSE : (app.current_mode == MODE_POMODORO ? DEFAULT_ICON : ICON_BREAK)) : DEFAULT_ICON;
-    GdkPixbuf *p_buf = gdk_pixbuf_new_from_file_at_size(img_path, 16, 16, NULL);
-    gtk_image_set_from_pixbuf(GTK_IMAGE(always_on_top_icon), p_buf);
+    if (img_path != current_img_path) {
+        GdkPixbuf *p_buf = gdk_pixbuf_new_from_file_at_size(img_path, 16, 16, NULL);
+        gtk_image_set_from_pixbuf(GTK_IMAGE(always_on_top_icon), p_buf);
+        if (p_buf) g_object_unref(p_buf);
+        current_img_path = img_path;
+    }
+    TRACE_END(span, "update_always_on_top_label");
 }
 
 static void update_play_pause_icon() {
@@ -301,6 +271,12 @@ static void update_play_pause_icon() {
         update_always_on_top_label();
         gtk_button_set_image(GTK_BUTTON(play_pause_button), image);
     }
+    if (!app.timer_active || app.timer_paused) {
+        countdown_stop();
+        disarm_phase_end();
+    }
+    update_idle_watch();
+    update_tray_menu();
 }
 
 static void on_start_activate() {
@@ -349,6 +325,13 @@ static void on_quit_activate() {
     gtk_main_quit();
 }
 
+// a session logout or ctrl-c quits through the main loop so the exit path
+// (and the trace flush registered with atexit) still runs
+static gboolean on_quit_signal(gpointer user_data) {
+    on_quit_activate();
+    return G_SOURCE_REMOVE;
+}
+
 static void on_config_activate() {
     create_config_window();
 }
@@ -430,6 +413,62 @@ static void on_stop_button_clicked_confirm() {
     on_stop_button_clicked();
 }
 
+static void on_user_idle(int idle_seconds) {
+    // only work time is tracked, walking away during a break is the point of a break
+    if (!app.timer_active || app.timer_paused || app.current_mode != MODE_POMODORO)
+        return;
+
+    // the user left idle_seconds ago, those seconds were not worked
+    app.remaining_seconds += idle_seconds;
+    if (app.remaining_seconds > app.pomodoro_duration)
+        app.remaining_seconds = app.pomodoro_duration;
+
+    // set before pausing so the idle watch keeps running to notice the return
+    idle_paused = TRUE;
+    on_play_pause_button_clicked();
+}
+
+static void on_user_return(int idle_seconds) {
+    if (!idle_paused) return;
+    idle_paused = FALSE;
+
+    // the user may have resumed or stopped by hand in the meantime
+    if (!app.timer_active || !app.timer_paused) {
+        update_idle_watch();
+        return;
+    }
+
+    if (app.idle_resume_ask) {
+        GtkWidget *dialog = gtk_message_dialog_new(
+            GTK_WINDOW(NULL),
+            GTK_DIALOG_MODAL,
+            GTK_MESSAGE_QUESTION,
+            GTK_BUTTONS_YES_NO,
+            "%s", _("Welcome back! Resume the pomodoro?")
+        );
+        int response = gtk_dialog_run(GTK_DIALOG(dialog));
+        gtk_widget_destroy(dialog);
+
+        if (response != GTK_RESPONSE_YES || !app.timer_active || !app.timer_paused) {
+            update_idle_watch();
+            return;
+        }
+    }
+
+    on_play_pause_button_clicked();
+}
+
+// idle is only polled during a running pomodoro, or while one is paused
+// waiting for the user to come back
+static void update_idle_watch() {
+    gboolean watch = app.idle_timeout > 0 &&
+        (idle_paused || (app.timer_active && !app.timer_paused && app.current_mode == MODE_POMODORO));
+
+    if (watch && idle_init(app.idle_timeout * 60, on_user_idle, on_user_return) != 0)
+        watch = FALSE;
+    idle_watch(watch);
+}
+
 static void create_chronometer_floating_window() {
     if (!always_on_top_window) {
         always_on_top_window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
@@ -448,6 +487,7 @@ static void create_chronometer_floating_window() {
         
         GdkPixbuf *p_buf = gdk_pixbuf_new_from_file_at_size(DEFAULT_ICON, 16, 16, NULL);
         always_on_top_icon = gtk_image_new_from_pixbuf(p_buf);
+        if (p_buf) g_object_unref(p_buf);
 
         gtk_box_pack_start(GTK_BOX(hbox), always_on_top_icon, FALSE, FALSE, 4);
 
@@ -480,19 +520,23 @@ static void on_config_save_clicked(GtkButton *button) {
     GtkWidget *long_break_entry = g_object_get_data(G_OBJECT(button), "long_break_entry");
     GtkWidget *pomodoros_count_entry = g_object_get_data(G_OBJECT(button), "pomodoros_count_entry");
     GtkWidget *volume_scale = g_object_get_data(G_OBJECT(button), "volume_scale");
+    GtkWidget *all_monitors_check = g_object_get_data(G_OBJECT(button), "all_monitors_check");
+    GtkWidget *idle_entry = g_object_get_data(G_OBJECT(button), "idle_entry");
 
     const char *pomo_text = gtk_entry_get_text(GTK_ENTRY(pomodoro_entry));
     const char *break_text = gtk_entry_get_text(GTK_ENTRY(break_entry));
     const char *long_break_text = gtk_entry_get_text(GTK_ENTRY(long_break_entry));
     const char *count_text = gtk_entry_get_text(GTK_ENTRY(pomodoros_count_entry));
+    const char *idle_text = gtk_entry_get_text(GTK_ENTRY(idle_entry));
 
     int pomo_minutes = atoi(pomo_text);
     int break_minutes = atoi(break_text);
     int long_break_minutes = atoi(long_break_text);
     int count = atoi(count_text);
+    int idle_minutes = atoi(idle_text);
     int volume = (int) gtk_range_get_value(GTK_RANGE(volume_scale));
 
-    if (pomo_minutes < 1 || break_minutes < 1 || long_break_minutes < 1 || count < 1) {
+    if (pomo_minutes < 1 || break_minutes < 1 || long_break_minutes < 1 || count < 1 || idle_minutes < 0) {
         GtkWidget *dialog = gtk_message_dialog_new(GTK_WINDOW(config_window),
                                                      GTK_DIALOG_MODAL,
                                                      GTK_MESSAGE_ERROR,
@@ -508,8 +552,11 @@ static void on_config_save_clicked(GtkButton *button) {
     app.long_break_duration  = long_break_minutes * 60;
     app.pomodoros_before_long = count;
     app.volume_level         = volume;
+    app.osd_all_monitors     = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(all_monitors_check));
+    app.idle_timeout         = idle_minutes;
 
     save_config(app);
+    update_idle_watch();
 
     gtk_widget_destroy(config_window);
     config_window = NULL;
@@ -544,17 +591,22 @@ static void create_config_window() {
     GtkWidget *pomodoros_count_label = gtk_label_new(_("Pomodoros before Long Break:"));
     GtkWidget *volume_label = gtk_label_new(_("Volume Level:"));
     GtkWidget *notification_delay_label = gtk_label_new(_("Notification Delay (seconds):"));
+    GtkWidget *idle_label = gtk_label_new(_("Auto-pause when idle (minutes, 0 = off):"));
 
     GtkWidget *pomodoro_entry = gtk_entry_new();
     GtkWidget *break_entry = gtk_entry_new();
     GtkWidget *long_break_entry = gtk_entry_new();
     GtkWidget *pomodoros_count_entry = gtk_entry_new();
+    GtkWidget *idle_entry = gtk_entry_new();
     GtkWidget *volume_scale = gtk_scale_new_with_range(GTK_ORIENTATION_HORIZONTAL, 0, 100, 1);
     gtk_range_set_value(GTK_RANGE(volume_scale), app.volume_level);
     
     GtkWidget *notification_delay_scale = gtk_scale_new_with_range(GTK_ORIENTATION_HORIZONTAL, 2, 60, 1);
     gtk_range_set_value(GTK_RANGE(notification_delay_scale), app.notification_delay);
 
+    GtkWidget *all_monitors_check = gtk_check_button_new_with_label(_("Show alert on all monitors"));
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(all_monitors_check), app.osd_all_monitors);
+
     char buffer[16];
     snprintf(buffer, sizeof(buffer), "%d", app.pomodoro_duration / 60);
     gtk_entry_set_text(GTK_ENTRY(pomodoro_entry), buffer);
@@ -564,6 +616,8 @@ static void create_config_window() {
     gtk_entry_set_text(GTK_ENTRY(long_break_entry), buffer);
     snprintf(buffer, sizeof(buffer), "%d", app.pomodoros_before_long);
     gtk_entry_set_text(GTK_ENTRY(pomodoros_count_entry), buffer);
+    snprintf(buffer, sizeof(buffer), "%d", app.idle_timeout);
+    gtk_entry_set_text(GTK_ENTRY(idle_entry), buffer);
 
     gtk_grid_attach(GTK_GRID(grid), pomodoro_label, 0, 0, 1, 1);
     gtk_grid_attach(GTK_GRID(grid), pomodoro_entry, 1, 0, 1, 1);
@@ -577,15 +631,20 @@ static void create_config_window() {
     gtk_grid_attach(GTK_GRID(grid), volume_scale, 1, 4, 1, 1);
     gtk_grid_attach(GTK_GRID(grid), notification_delay_label, 0, 5, 1, 1);
     gtk_grid_attach(GTK_GRID(grid), notification_delay_scale, 1, 5, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), all_monitors_check, 0, 6, 2, 1);
+    gtk_grid_attach(GTK_GRID(grid), idle_label, 0, 7, 1, 1);
+    gtk_grid_attach(GTK_GRID(grid), idle_entry, 1, 7, 1, 1);
 
     GtkWidget *save_button = gtk_button_new_with_label(_("Save"));
-    gtk_grid_attach(GTK_GRID(grid), save_button, 0, 6, 2, 1);
+    gtk_grid_attach(GTK_GRID(grid), save_button, 0, 8, 2, 1);
 
     g_object_set_data(G_OBJECT(save_button), "pomodoro_entry", pomodoro_entry);
     g_object_set_data(G_OBJECT(save_button), "break_entry", break_entry);
     g_object_set_data(G_OBJECT(save_button), "long_break_entry", long_break_entry);
     g_object_set_data(G_OBJECT(save_button), "pomodoros_count_entry", pomodoros_count_entry);
     g_object_set_data(G_OBJECT(save_button), "volume_scale", volume_scale);
+    g_object_set_data(G_OBJECT(save_button), "all_monitors_check", all_monitors_check);
+    g_object_set_data(G_OBJECT(save_button), "idle_entry", idle_entry);
 
     g_signal_connect(save_button, "clicked", G_CALLBACK(on_config_save_clicked), NULL);
     g_signal_connect(config_window, "destroy", G_CALLBACK(on_config_window_destroy), NULL);
@@ -593,41 +652,201 @@ static void create_config_window() {
     gtk_widget_show_all(config_window);
 }
 
-static gboolean on_tray_icon_button_press(GtkStatusIcon *status_icon, GdkEventButton *event) {
-    if (event->button == GDK_BUTTON_PRIMARY || event->button == GDK_BUTTON_SECONDARY) {
-        GtkWidget *menu = gtk_menu_new();
+static void update_tray_menu() {
+    if (!tray_menu) return;
+    gtk_menu_item_set_label(GTK_MENU_ITEM(tray_start_item), app.timer_active && !app.timer_paused ? _("Pause") : _("Start"));
+    gtk_widget_set_visible(tray_stop_item, app.timer_active);
+}
 
-        GtkWidget *start_item = gtk_menu_item_new_with_label(app.timer_active && !app.timer_paused ? _("Pause") : _("Start"));
-        g_signal_connect(start_item, "activate", G_CALLBACK(on_start_activate), NULL);
-        gtk_menu_shell_append(GTK_MENU_SHELL(menu), start_item);
-        
-        if (app.timer_active) {
-            GtkWidget *stop_item = gtk_menu_item_new_with_label(_("Stop"));
-            g_signal_connect(stop_item, "activate", G_CALLBACK(on_stop_activate), NULL);
-            gtk_menu_shell_append(GTK_MENU_SHELL(menu), stop_item);
-        }
+static gboolean on_tray_menu_draw(GtkWidget *widget, cairo_t *cr) {
+    if (tray_menu_click_ns) {
+        uint64_t now = trace_now();
+#ifdef FOSSODORO_SOAK
+        uint64_t latency = now - tray_menu_click_ns;
+        tray_menu_latency.count++;
+        tray_menu_latency.total_ns += latency;
+        if (latency > tray_menu_latency.max_ns) tray_menu_latency.max_ns = latency;
+#endif
+        if (trace_enabled) trace_record("tray_menu:click_to_draw", tray_menu_click_ns, now);
+        tray_menu_click_ns = 0;
+    }
+    return FALSE;
+}
+
+static void create_tray_menu() {
+    tray_menu = gtk_menu_new();
+
+    tray_start_item = gtk_menu_item_new_with_label(_("Start"));
+    g_signal_connect(tray_start_item, "activate", G_CALLBACK(on_start_activate), NULL);
+    gtk_menu_shell_append(GTK_MENU_SHELL(tray_menu), tray_start_item);
+
+    tray_stop_item = gtk_menu_item_new_with_label(_("Stop"));
+    g_signal_connect(tray_stop_item, "activate", G_CALLBACK(on_stop_activate), NULL);
+    gtk_menu_shell_append(GTK_MENU_SHELL(tray_menu), tray_stop_item);
 
-        GtkWidget *toggle_item = gtk_menu_item_new_with_label(_("Toggle Chronometer"));
-        g_signal_connect(toggle_item, "activate", G_CALLBACK(on_toggle_always_on_top_activate), NULL);
-        gtk_menu_shell_append(GTK_MENU_SHELL(menu), toggle_item);
+    GtkWidget *toggle_item = gtk_menu_item_new_with_label(_("Toggle Chronometer"));
+    g_signal_connect(toggle_item, "activate", G_CALLBACK(on_toggle_always_on_top_activate), NULL);
+    gtk_menu_shell_append(GTK_MENU_SHELL(tray_menu), toggle_item);
 
-        GtkWidget *config_item = gtk_menu_item_new_with_label(_("Configure"));
-        g_signal_connect(config_item, "activate", G_CALLBACK(on_config_activate), NULL);
-        gtk_menu_shell_append(GTK_MENU_SHELL(menu), config_item);
+    GtkWidget *config_item = gtk_menu_item_new_with_label(_("Configure"));
+    g_signal_connect(config_item, "activate", G_CALLBACK(on_config_activate), NULL);
+    gtk_menu_shell_append(GTK_MENU_SHELL(tray_menu), config_item);
 
-        GtkWidget *quit_item = gtk_menu_item_new_with_label(_("Quit"));
-        g_signal_connect(quit_item, "activate", G_CALLBACK(on_quit_activate), NULL);
-        gtk_menu_shell_append(GTK_MENU_SHELL(menu), quit_item);
+    GtkWidget *quit_item = gtk_menu_item_new_with_label(_("Quit"));
+    g_signal_connect(quit_item, "activate", G_CALLBACK(on_quit_activate), NULL);
+    gtk_menu_shell_append(GTK_MENU_SHELL(tray_menu), quit_item);
 
-        gtk_widget_show_all(menu);
-        gtk_menu_popup_at_pointer(GTK_MENU(menu), (GdkEvent *) event);
+    g_signal_connect(tray_menu, "draw", G_CALLBACK(on_tray_menu_draw), NULL);
+
+    gtk_widget_show_all(tray_menu);
+    update_tray_menu();
+}
+
+static gboolean on_tray_icon_button_press(GtkStatusIcon *status_icon, GdkEventButton *event) {
+    if (event->button == GDK_BUTTON_PRIMARY || event->button == GDK_BUTTON_SECONDARY) {
+        // the menu is kept up to date by update_tray_menu, opening it is just the popup
+        tray_menu_click_ns = trace_now();
+        gtk_menu_popup_at_pointer(GTK_MENU(tray_menu), (GdkEvent *) event);
         return TRUE;
     }
     return FALSE;
 }
 
+#ifdef FOSSODORO_SOAK
+#define SOAK_WINDOWS            20
+#define SOAK_WARMUP_WINDOWS     2
+#define SOAK_MENU_EVERY         1000
+#define SOAK_LIVE_BYTES_SLACK   (64 * 1024)
+#define SOAK_RSS_SLACK_KB       1024
+#define SOAK_MAX_DINGS          4
+#define SOAK_CANCEL_EVERY       7
+
+static void soak_pump_events() {
+    while (gtk_events_pending())
+        gtk_main_iteration_do(FALSE);
+}
+
+// each phase end fires a ding thread, keep a few in flight and let them all
+// finish before measuring so decoded samples don't count as growth. An armed
+// alert holds one until it fires, never wait for zero while armed
+static void soak_wait_dings(int max_pending) {
+    while (sound_pending() > max_pending)
+        g_usleep(1000);
+}
+
+static void soak_open_menu() {
+    GdkEvent *event = gdk_event_new(GDK_BUTTON_PRESS);
+    event->button.button = GDK_BUTTON_SECONDARY;
+    event->button.time = GDK_CURRENT_TIME;
+    event->button.window = g_object_ref(gdk_get_default_root_window());
+    gdk_event_set_device(event, gdk_seat_get_pointer(gdk_display_get_default_seat(gdk_display_get_default())));
+
+    on_tray_icon_button_press(tray_icon, &event->button);
+    soak_pump_events();
+    gtk_menu_shell_cancel(GTK_MENU_SHELL(tray_menu));
+    soak_pump_events();
+
+    gdk_event_free(event);
+}
+
+// drives the tick path, phase transitions, alert jobs and menu opens as fast as possible
+// and fails when memory keeps growing once the caches are warm
+static int run_soak(long ticks) {
+    soak_alloc_stats_t stats, baseline_stats;
+    long baseline_rss = 0, rss = 0;
+    long window = ticks / SOAK_WINDOWS > 0 ? ticks / SOAK_WINDOWS : 1;
+    long next_window = window;
+    int windows = 0;
+
+    alerts_headless = TRUE;
+    sound_set_driver("null");
+    app.pomodoro_duration = 25;
+    app.break_duration = 5;
+    app.long_break_duration = 15;
+    app.pomodoros_before_long = 4;
+
+    app.always_on_top_enabled = TRUE;
+    gtk_widget_show_all(always_on_top_window);
+    on_play_pause_button_clicked();
+    soak_pump_events();
+
+    soak_get_alloc_stats(&baseline_stats);
+    for (long tick = 1; tick <= ticks; tick++) {
+        timer_callback();
+        soak_wait_dings(SOAK_MAX_DINGS - 1);
+
+        // breaks end paused, resume like a user would
+        if (app.timer_paused)
+            on_play_pause_button_clicked();
+
+        // pausing inside the pre-arm window cancels the jobs, the next tick arms again
+        if (alert_armed() && tick % SOAK_CANCEL_EVERY == 0) {
+            on_play_pause_button_clicked();
+            on_play_pause_button_clicked();
+        }
+
+        if (tick % SOAK_MENU_EVERY == 0)
+            soak_open_menu();
+
+        if (tick % 100 == 0)
+            soak_pump_events();
+
+        // a window ending while armed is measured once the alert has fired
+        if (tick >= next_window && !alert_armed()) {
+            next_window += window;
+            windows++;
+            soak_wait_dings(0);
+            soak_get_alloc_stats(&stats);
+            rss = soak_get_rss_kb();
+            if (windows == SOAK_WARMUP_WINDOWS) {
+                baseline_stats = stats;
+                baseline_rss = rss;
+            }
+            printf("soak tick=%ld allocs=%llu frees=%llu live_bytes=%lld rss_kb=%ld\n",
+                   tick, stats.allocs, stats.frees, stats.live_bytes, rss);
+            fflush(stdout);
+        }
+    }
+
+    alert_disarm();
+    soak_wait_dings(0);
+    soak_get_alloc_stats(&stats);
+    rss = soak_get_rss_kb();
+    long long live_growth = stats.live_bytes - baseline_stats.live_bytes;
+    long rss_growth = rss - baseline_rss;
+
+    printf("soak done ticks=%ld live_growth_bytes=%lld rss_growth_kb=%ld\n", ticks, live_growth, rss_growth);
+    if (tray_menu_latency.count > 0)
+        printf("soak menu opens=%lu click_to_draw_avg_us=%.1f click_to_draw_max_us=%.1f\n",
+               tray_menu_latency.count,
+               tray_menu_latency.total_ns / 1000.0 / tray_menu_latency.count,
+               tray_menu_latency.max_ns / 1000.0);
+    if (live_growth > SOAK_LIVE_BYTES_SLACK || rss_growth > SOAK_RSS_SLACK_KB) {
+        fprintf(stderr, "soak failed: memory keeps growing in steady state\n");
+        return 1;
+    }
+    return 0;
+}
+#endif
+
 int main(int argc, char *argv[]) {
+    // the prepared OSD runs on its own thread with its own X connection
+    XInitThreads();
     gtk_init(&argc, &argv);
+    sound_init();
+
+#ifdef FOSSODORO_SOAK
+    long soak_ticks = 0;
+    char *soak_config = NULL;
+#endif
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--trace=", 8) == 0)
+            trace_init(argv[i] + 8);
+#ifdef FOSSODORO_SOAK
+        else if (strncmp(argv[i], "--soak=", 7) == 0)
+            soak_ticks = atol(argv[i] + 7);
+#endif
+    }
 
     setlocale (LC_ALL, "");
     bindtextdomain (GETTEXT_PACKAGE, DATADIR "locale");
@@ -636,6 +855,14 @@ int main(int argc, char *argv[]) {
 
     notify_init(_("Pomodoro Timer"));
 
+#ifdef FOSSODORO_SOAK
+    // defaults only, a soak run never reads the user's settings
+    if (soak_ticks > 0) {
+        soak_config = g_build_filename(g_get_tmp_dir(), "fossodoro-soak.cfg", NULL);
+        remove(soak_config);
+        set_config_path(soak_config);
+    }
+#endif
     load_config();
 
     app.current_pomodoro_count = 0;
@@ -650,10 +877,36 @@ int main(int argc, char *argv[]) {
     g_signal_connect(tray_icon, "button-press-event", G_CALLBACK(on_tray_icon_button_press), NULL);
 
     create_chronometer_floating_window();
+    create_tray_menu();
+
+#ifdef FOSSODORO_SOAK
+    // no hotkey grabs or idle polling, a soak run must not touch the session
+    if (soak_ticks > 0) {
+        int res = run_soak(soak_ticks);
+        set_config_path(NULL);
+        g_free(soak_config);
+        notify_uninit();
+        sound_shutdown();
+        return res;
+    }
+#endif
+
+    // stopping resets the pomodoro, a stray key press asks first like the stop button
+    if ((app.hotkey_play_pause[0] || app.hotkey_stop[0]) && hotkeys_init() == 0) {
+        hotkeys_bind(app.hotkey_play_pause, on_play_pause_button_clicked);
+        hotkeys_bind(app.hotkey_stop, on_stop_button_clicked_confirm);
+    }
+
+    g_unix_signal_add(SIGTERM, on_quit_signal, NULL);
+    g_unix_signal_add(SIGINT, on_quit_signal, NULL);
 
     gtk_main();
 
+    idle_shutdown();
+    hotkeys_shutdown();
+    alert_disarm();
     notify_uninit();
+    sound_shutdown();
     return 0;
 }
 
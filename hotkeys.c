@@ -0,0 +1,185 @@
+#include <gtk/gtk.h>
+#include <X11/Xlib.h>
+#include <X11/XKBlib.h>
+#include <X11/keysym.h>
+#include "hotkeys.h"
+#include "trace.h"
+
+#define HOTKEY_MODIFIERS (ShiftMask | ControlMask | Mod1Mask | Mod2Mask | Mod3Mask | Mod4Mask | Mod5Mask)
+
+typedef struct {
+    guint keyval;
+    unsigned int modifiers;
+    KeyCode keycode;
+    gboolean pressed;
+    hotkey_callback_t callback;
+} hotkey_t;
+
+static Display *hotkey_dpy;
+static Window hotkey_root;
+static guint hotkey_watch;
+static hotkey_t hotkeys[HOTKEYS_MAX];
+static int hotkey_count;
+static unsigned int numlock_mask;
+static int hotkey_grab_failed;
+static XErrorHandler hotkey_prev_handler;
+
+static int hotkeys_error_handler(Display *dpy, XErrorEvent *ev) {
+    if (dpy == hotkey_dpy) {
+        hotkey_grab_failed = 1;
+        return 0;
+    }
+    return hotkey_prev_handler ? hotkey_prev_handler(dpy, ev) : 0;
+}
+
+static unsigned int hotkeys_get_numlock_mask() {
+    unsigned int mask = 0;
+    KeyCode numlock = XKeysymToKeycode(hotkey_dpy, XK_Num_Lock);
+    XModifierKeymap *map = XGetModifierMapping(hotkey_dpy);
+    if (!map) return 0;
+
+    for (int i = 0; i < 8 && numlock; i++)
+        for (int j = 0; j < map->max_keypermod; j++)
+            if (map->modifiermap[i * map->max_keypermod + j] == numlock)
+                mask = 1 << i;
+
+    XFreeModifiermap(map);
+    return mask;
+}
+
+// grabs every NumLock/CapsLock combination so the hotkey works whatever the lock state is
+static void hotkeys_grab(hotkey_t *hk, int grab) {
+    unsigned int variants[] = { 0, LockMask, numlock_mask, numlock_mask | LockMask };
+    int n = numlock_mask ? 4 : 2;
+
+    if (!hk->keycode) return;
+
+    for (int i = 0; i < n; i++) {
+        if (grab)
+            XGrabKey(hotkey_dpy, hk->keycode, hk->modifiers | variants[i], hotkey_root, True, GrabModeAsync, GrabModeAsync);
+        else
+            XUngrabKey(hotkey_dpy, hk->keycode, hk->modifiers | variants[i], hotkey_root);
+    }
+}
+
+// BadAccess means another client owns the combination, trap it instead of exiting
+static int hotkeys_grab_range(int first, int last, int grab) {
+    hotkey_grab_failed = 0;
+    hotkey_prev_handler = XSetErrorHandler(hotkeys_error_handler);
+    for (int i = first; i < last; i++)
+        hotkeys_grab(&hotkeys[i], grab);
+    XSync(hotkey_dpy, False);
+    XSetErrorHandler(hotkey_prev_handler);
+    return hotkey_grab_failed;
+}
+
+static int hotkeys_grab_all(int grab) {
+    return hotkeys_grab_range(0, hotkey_count, grab);
+}
+
+static void hotkeys_remap(XMappingEvent *ev) {
+    hotkeys_grab_all(0);
+    XRefreshKeyboardMapping(ev);
+
+    numlock_mask = hotkeys_get_numlock_mask();
+    for (int i = 0; i < hotkey_count; i++)
+        hotkeys[i].keycode = XKeysymToKeycode(hotkey_dpy, hotkeys[i].keyval);
+
+    if (hotkeys_grab_all(1))
+        fprintf(stderr, "Unable to grab global hotkeys after keyboard remap\n");
+}
+
+static gboolean hotkeys_dispatch(GIOChannel *source, GIOCondition condition, gpointer user_data) {
+    XEvent ev;
+
+    while (XPending(hotkey_dpy)) {
+        XNextEvent(hotkey_dpy, &ev);
+
+        if (ev.type == MappingNotify) {
+            hotkeys_remap(&ev.xmapping);
+            continue;
+        }
+        if (ev.type != KeyPress && ev.type != KeyRelease)
+            continue;
+
+        unsigned int state = ev.xkey.state & HOTKEY_MODIFIERS & ~numlock_mask;
+        for (int i = 0; i < hotkey_count; i++) {
+            hotkey_t *hk = &hotkeys[i];
+            if (hk->keycode != ev.xkey.keycode)
+                continue;
+
+            // modifiers may already be up when the key is released
+            if (ev.type == KeyRelease) {
+                hk->pressed = FALSE;
+                continue;
+            }
+
+            // with detectable auto repeat a held key only sends presses, fire once
+            if (hk->modifiers == state && !hk->pressed) {
+                TRACE_BEGIN(span);
+                hk->pressed = TRUE;
+                hk->callback();
+                TRACE_END(span, "hotkey_dispatch");
+            }
+        }
+    }
+    return TRUE;
+}
+
+int hotkeys_init() {
+    if (hotkey_dpy) return 0;
+
+    hotkey_dpy = XOpenDisplay(NULL);
+    if (!hotkey_dpy) {
+        fprintf(stderr, "Unable to open X display\n");
+        return 1;
+    }
+    hotkey_root = DefaultRootWindow(hotkey_dpy);
+    numlock_mask = hotkeys_get_numlock_mask();
+    XkbSetDetectableAutoRepeat(hotkey_dpy, True, NULL);
+
+    GIOChannel *channel = g_io_channel_unix_new(ConnectionNumber(hotkey_dpy));
+    hotkey_watch = g_io_add_watch_full(channel, G_PRIORITY_HIGH, G_IO_IN, hotkeys_dispatch, NULL, NULL);
+    g_io_channel_unref(channel);
+    return 0;
+}
+
+int hotkeys_bind(const char *accelerator, hotkey_callback_t callback) {
+    guint keyval;
+    GdkModifierType mods;
+
+    if (!hotkey_dpy || !accelerator || !*accelerator) return 1;
+    if (hotkey_count >= HOTKEYS_MAX) return 1;
+
+    gtk_accelerator_parse(accelerator, &keyval, &mods);
+    if (!keyval) {
+        fprintf(stderr, "Invalid hotkey %s\n", accelerator);
+        return 1;
+    }
+
+    hotkey_t *hk = &hotkeys[hotkey_count];
+    hk->keyval = keyval;
+    hk->modifiers = mods & HOTKEY_MODIFIERS;
+    if (mods & GDK_SUPER_MASK) hk->modifiers |= Mod4Mask;
+    hk->keycode = XKeysymToKeycode(hotkey_dpy, keyval);
+    hk->pressed = FALSE;
+    hk->callback = callback;
+
+    if (!hk->keycode || hotkeys_grab_range(hotkey_count, hotkey_count + 1, 1)) {
+        hotkeys_grab_range(hotkey_count, hotkey_count + 1, 0);
+        fprintf(stderr, "Unable to grab hotkey %s\n", accelerator);
+        return 1;
+    }
+    hotkey_count++;
+    return 0;
+}
+
+void hotkeys_shutdown() {
+    if (!hotkey_dpy) return;
+    if (hotkey_watch) g_source_remove(hotkey_watch);
+    hotkeys_grab_all(0);
+    XCloseDisplay(hotkey_dpy);
+    hotkey_dpy = NULL;
+    hotkey_watch = 0;
+    hotkey_count = 0;
+}
@@ -0,0 +1,14 @@
+#ifndef FOSSODORO_HOTKEYS_H
+#define FOSSODORO_HOTKEYS_H
+
+#ifndef HOTKEYS_MAX
+#define HOTKEYS_MAX 8
+#endif
+
+typedef void (*hotkey_callback_t)();
+
+int hotkeys_init();
+int hotkeys_bind(const char *accelerator, hotkey_callback_t callback);
+void hotkeys_shutdown();
+
+#endif // FOSSODORO_HOTKEYS_H
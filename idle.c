@@ -0,0 +1,140 @@
+#include <glib.h>
+#include <stdio.h>
+#include <X11/Xlib.h>
+#include <X11/extensions/scrnsaver.h>
+#include "idle.h"
+#include "trace.h"
+
+static Display *idle_dpy;
+static XScreenSaverInfo *idle_info;
+static guint idle_source;
+static unsigned long idle_threshold_ms;
+static int idle_away;
+static int idle_unavailable;
+static idle_callback_t idle_on_idle;
+static idle_callback_t idle_on_return;
+static idle_stats_t idle_stats;
+
+static gboolean idle_poll(gpointer user_data);
+
+static void idle_schedule(guint interval_ms) {
+    idle_source = g_timeout_add(interval_ms, idle_poll, NULL);
+}
+
+// idle time grows at most as fast as the clock, so nothing can happen before
+// the remaining distance to the threshold has elapsed. Once away, a return is
+// noticed quickly at first and with a delay proportional to the absence later
+static guint idle_next_interval(unsigned long idle_ms) {
+    unsigned long wait;
+
+    if (idle_away) {
+        wait = (idle_ms - idle_threshold_ms) / IDLE_AWAY_BACKOFF;
+        if (wait < IDLE_AWAY_POLL_MS) wait = IDLE_AWAY_POLL_MS;
+    } else {
+        wait = idle_ms < idle_threshold_ms ? idle_threshold_ms - idle_ms : 0;
+        if (wait < IDLE_MIN_POLL_MS) wait = IDLE_MIN_POLL_MS;
+    }
+    if (wait > IDLE_MAX_POLL_MS) wait = IDLE_MAX_POLL_MS;
+    return (guint) wait;
+}
+
+static gboolean idle_poll(gpointer user_data) {
+    uint64_t start = trace_now();
+    Status ok = XScreenSaverQueryInfo(idle_dpy, DefaultRootWindow(idle_dpy), idle_info);
+    uint64_t end = trace_now();
+
+    idle_stats.polls++;
+    idle_stats.query_ns += end - start;
+    if (trace_enabled) trace_record("idle_poll", start, end);
+
+    if (!ok) {
+        idle_schedule(IDLE_MAX_POLL_MS);
+        return FALSE;
+    }
+
+    unsigned long idle_ms = idle_info->idle;
+    int was_away = idle_away;
+    if (!idle_away && idle_ms >= idle_threshold_ms)
+        idle_away = 1;
+    else if (idle_away && idle_ms < idle_threshold_ms)
+        idle_away = 0;
+
+    // schedule first, the callbacks may run a nested main loop
+    idle_schedule(idle_next_interval(idle_ms));
+
+    if (idle_away && !was_away && idle_on_idle)
+        idle_on_idle((int) (idle_ms / 1000));
+    else if (!idle_away && was_away && idle_on_return)
+        idle_on_return((int) (idle_ms / 1000));
+
+    return FALSE;
+}
+
+int idle_init(int threshold_seconds, idle_callback_t on_idle, idle_callback_t on_return) {
+    int event_base, error_base;
+
+    if (threshold_seconds < 1) return 1;
+    idle_threshold_ms = (unsigned long) threshold_seconds * 1000;
+    idle_on_idle = on_idle;
+    idle_on_return = on_return;
+    if (idle_dpy) return 0;
+    // callers retry on every timer state change, only try (and complain) once
+    if (idle_unavailable) return 1;
+
+    idle_dpy = XOpenDisplay(NULL);
+    if (!idle_dpy) {
+        fprintf(stderr, "Unable to open X display\n");
+        idle_unavailable = 1;
+        return 1;
+    }
+    if (!XScreenSaverQueryExtension(idle_dpy, &event_base, &error_base) ||
+        !(idle_info = XScreenSaverAllocInfo())) {
+        fprintf(stderr, "XScreenSaver extension not available, idle detection disabled\n");
+        XCloseDisplay(idle_dpy);
+        idle_dpy = NULL;
+        idle_unavailable = 1;
+        return 1;
+    }
+
+    idle_stats.polls = 0;
+    idle_stats.query_ns = 0;
+    idle_stats.started_ns = trace_now();
+    return 0;
+}
+
+// polling only happens while watched, a stopped timer costs no wakeups
+void idle_watch(int watch) {
+    if (!idle_dpy || watch == (idle_source != 0)) return;
+
+    if (watch) {
+        idle_away = 0;
+        idle_schedule(idle_next_interval(0));
+    } else {
+        g_source_remove(idle_source);
+        idle_source = 0;
+    }
+}
+
+void idle_shutdown() {
+    if (!idle_dpy) return;
+
+    if (trace_enabled) {
+        idle_stats_t stats;
+        idle_get_stats(&stats);
+        double elapsed = (trace_now() - stats.started_ns) / 1e9;
+        fprintf(stderr, "idle: %lu polls in %.0fs (%.2f wakeups/min, %.1fus avg query)\n",
+                stats.polls, elapsed,
+                elapsed > 0 ? stats.polls * 60.0 / elapsed : 0.0,
+                stats.polls ? stats.query_ns / 1000.0 / stats.polls : 0.0);
+    }
+
+    idle_watch(0);
+    XFree(idle_info);
+    idle_info = NULL;
+    XCloseDisplay(idle_dpy);
+    idle_dpy = NULL;
+}
+
+void idle_get_stats(idle_stats_t *stats) {
+    *stats = idle_stats;
+}
@@ -0,0 +1,35 @@
+#ifndef FOSSODORO_IDLE_H
+#define FOSSODORO_IDLE_H
+
+#include <stdint.h>
+
+#ifndef IDLE_MIN_POLL_MS
+#define IDLE_MIN_POLL_MS        250     // never poll faster than this, even right at the threshold
+#endif
+
+#ifndef IDLE_MAX_POLL_MS
+#define IDLE_MAX_POLL_MS        60000   // longest sleep while the user is active
+#endif
+
+#ifndef IDLE_AWAY_POLL_MS
+#define IDLE_AWAY_POLL_MS       1000    // while idle, how quickly a user who just left is noticed back
+#endif
+
+#ifndef IDLE_AWAY_BACKOFF
+#define IDLE_AWAY_BACKOFF       10      // while idle, poll every 1/N of the time away (up to IDLE_MAX_POLL_MS)
+#endif
+
+typedef void (*idle_callback_t)(int idle_seconds);
+
+typedef struct {
+    unsigned long polls;
+    uint64_t query_ns;
+    uint64_t started_ns;
+} idle_stats_t;
+
+int idle_init(int threshold_seconds, idle_callback_t on_idle, idle_callback_t on_return);
+void idle_watch(int watch);
+void idle_shutdown();
+void idle_get_stats(idle_stats_t *stats);
+
+#endif // FOSSODORO_IDLE_H
@@ -1,7 +1,12 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include "osd.h"
+#include "trace.h"
 
 void osd_render(cairo_t *cr, void *user_data)
 {
+    TRACE_BEGIN(span);
     osd_data_t *data = (osd_data_t*)user_data;
 
     cairo_set_source_rgba(cr, 1.0, 0.0, 0.0, 1);
@@ -38,6 +43,7 @@ void osd_render(cairo_t *cr, void *user_data)
     cairo_show_text(cr, data->text);
 
     cairo_stroke(cr);
+    TRACE_END(span, "osd_render");
 }
 
 int osd_calculate_thickness(osd_data_t *rects_data) {
@@ -55,72 +61,182 @@ int osd_calculate_thickness(osd_data_t *rects_data) {
     return rects_data->thickness;
 }
 
-int osd_get_mouse_monitor_dimension(osd_data_t *rects_data) {
+int osd_get_monitors(osd_monitor_t **monitors, int *pointer_monitor) {
 
     Display *dpy = XOpenDisplay(NULL);
     if (!dpy) {
         fprintf(stderr, "Unable to open X display\n");
-        return 1;
+        return -1;
     }
 
     Window root = DefaultRootWindow(dpy);
 
     int monitor_cnt;
-    XRRMonitorInfo *monitors = XRRGetMonitors(dpy, root, True, &monitor_cnt);
-    if (!monitors) return -1;
+    XRRMonitorInfo *info = XRRGetMonitors(dpy, root, True, &monitor_cnt);
+    if (!info || monitor_cnt < 1) {
+        if (info) XRRFreeMonitors(info);
+        XCloseDisplay(dpy);
+        return -1;
+    }
 
     Window ret_root, ret_child;
     int root_x, root_y, win_x, win_y;
     unsigned int mask;
     XQueryPointer(dpy, root, &ret_root, &ret_child, &root_x, &root_y, &win_x, &win_y, &mask);
 
-    int resut = -1;
+    *monitors = (osd_monitor_t*) malloc(monitor_cnt * sizeof(osd_monitor_t));
+    if (!*monitors) monitor_cnt = -1;
+    if (pointer_monitor) *pointer_monitor = -1;
 
     for (int i = 0; i < monitor_cnt; ++i) {
-        int mx = monitors[i].x;
-        int my = monitors[i].y;
-        int mw = monitors[i].width;
-        int mh = monitors[i].height;
-        if (root_x >= mx && root_x < mx + mw &&
-            root_y >= my && root_y < my + mh) {
-            rects_data->width = mw;
-            rects_data->height = mh;
-            resut = i;
-            break;
-        }
+        osd_monitor_t *m = &(*monitors)[i];
+        m->x = info[i].x;
+        m->y = info[i].y;
+        m->width = info[i].width;
+        m->height = info[i].height;
+        if (pointer_monitor && *pointer_monitor < 0 &&
+            root_x >= m->x && root_x < m->x + m->width &&
+            root_y >= m->y && root_y < m->y + m->height)
+            *pointer_monitor = i;
     }
 
-    XRRFreeMonitors(monitors);
+    XRRFreeMonitors(info);
     XCloseDisplay(dpy);
-    return resut;
+    return monitor_cnt;
 }
 
-int osd_run(const char *text, int duration) {
-    Aosd* aosd = aosd_new();
-    if (!aosd) {
-        fprintf(stderr, "Failed to create aosd object\n");
-        return 1;
+// renders the overlay once for a resolution, monitors with the same size share it
+static osd_layer_t *osd_get_layer(osd_layer_t *layers, int *layer_cnt, int width, int height, const char *text) {
+    for (int i = 0; i < *layer_cnt; i++)
+        if (layers[i].width == width && layers[i].height == height)
+            return &layers[i];
+
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy(surface);
+        return NULL;
     }
 
     osd_data_t rects_data;
+    rects_data.width = width;
+    rects_data.height = height;
+    rects_data.text = text;
+    osd_calculate_thickness(&rects_data);
+
+    cairo_t *cr = cairo_create(surface);
+    osd_render(cr, &rects_data);
+    cairo_destroy(cr);
+    cairo_surface_flush(surface);
+
+    osd_layer_t *layer = &layers[(*layer_cnt)++];
+    layer->width = width;
+    layer->height = height;
+    layer->surface = surface;
+    return layer;
+}
+
+static void osd_paint_layer(cairo_t *cr, void *user_data) {
+    cairo_set_source_surface(cr, (cairo_surface_t*) user_data, 0, 0);
+    cairo_paint(cr);
+}
+
+void osd_overlays_destroy(osd_overlays_t *o) {
+    for (int i = 0; o->osds && i < o->count; i++)
+        if (o->osds[i]) aosd_destroy(o->osds[i]);
+
+    for (int i = 0; i < o->layer_cnt; i++)
+        cairo_surface_destroy(o->layers[i].surface);
+
+    free(o->layers);
+    free(o->osds);
+    free(o->monitors);
+    memset(o, 0, sizeof(osd_overlays_t));
+}
+
+// does everything but mapping: monitor query, rendering and window creation
+int osd_overlays_create(osd_overlays_t *o, const char *text, int all_monitors) {
+    int pointer_monitor;
 
-    int i = osd_get_mouse_monitor_dimension(&rects_data);
-    if (i < 0) {
+    memset(o, 0, sizeof(osd_overlays_t));
+    int monitor_cnt = osd_get_monitors(&o->monitors, &pointer_monitor);
+    if (monitor_cnt < 1) {
         fprintf(stderr, "Failed to get monitor\n");
         return 1;
     }
 
-    rects_data.text = text;
+    int first = 0;
+    o->count = monitor_cnt;
+    if (!all_monitors) {
+        first = pointer_monitor >= 0 ? pointer_monitor : 0;
+        o->count = 1;
+    }
 
-    osd_calculate_thickness(&rects_data);
+    o->osds = (Aosd**) calloc(o->count, sizeof(Aosd*));
+    o->layers = (osd_layer_t*) calloc(o->count, sizeof(osd_layer_t));
+    if (!o->osds || !o->layers) {
+        osd_overlays_destroy(o);
+        return 1;
+    }
 
-    aosd_set_transparency(aosd, TRANSPARENCY_COMPOSITE);
-    aosd_set_hide_upon_mouse_event(aosd, 0);
-    aosd_set_position(aosd, i > 0 ? 2 : 0, rects_data.width, rects_data.height);
-    aosd_set_renderer(aosd, osd_render, &rects_data);
-    
-    aosd_show(aosd);
-    aosd_loop_for(aosd, duration * 1000);
-    
-    aosd_destroy(aosd);
-}
\ No newline at end of file
+    for (int i = 0; i < o->count; i++) {
+        osd_monitor_t *m = &o->monitors[first + i];
+        osd_layer_t *layer = osd_get_layer(o->layers, &o->layer_cnt, m->width, m->height, text);
+        if (!layer) continue;
+
+        o->osds[i] = aosd_new();
+        if (!o->osds[i]) {
+            fprintf(stderr, "Failed to create aosd object\n");
+            continue;
+        }
+        aosd_set_transparency(o->osds[i], TRANSPARENCY_COMPOSITE);
+        aosd_set_hide_upon_mouse_event(o->osds[i], 0);
+        aosd_set_geometry(o->osds[i], m->x, m->y, m->width, m->height);
+        aosd_set_renderer(o->osds[i], osd_paint_layer, layer->surface);
+    }
+    return 0;
+}
+
+// aosd_loop_once blocks in XNextEvent when nothing is queued, a zero length
+// aosd_loop_for only handles what is already pending on the connection
+static void osd_overlays_pump(osd_overlays_t *o) {
+    for (int i = 0; i < o->count; i++)
+        if (o->osds[i]) aosd_loop_for(o->osds[i], 0);
+}
+
+void osd_overlays_map(osd_overlays_t *o) {
+    // everything is rendered already, map the overlays back to back so they appear together
+    for (int i = 0; i < o->count; i++)
+        if (o->osds[i]) aosd_show(o->osds[i]);
+    osd_overlays_pump(o);
+}
+
+void osd_overlays_run(osd_overlays_t *o, int duration) {
+    uint64_t deadline = trace_now() + (uint64_t) duration * 1000000000ull;
+    for (uint64_t now = trace_now(); now < deadline; now = trace_now()) {
+        // answer exposes while up, the layers are already rendered so a repaint is a blit
+        osd_overlays_pump(o);
+
+        uint64_t wait = deadline - now < OSD_LOOP_NS ? deadline - now : OSD_LOOP_NS;
+        struct timespec ts = { (time_t) (wait / 1000000000ull), (long) (wait % 1000000000ull) };
+        nanosleep(&ts, NULL);
+    }
+
+    for (int i = 0; i < o->count; i++)
+        if (o->osds[i]) aosd_hide(o->osds[i]);
+    osd_overlays_pump(o);
+}
+
+int osd_run(const char *text, int duration, int all_monitors) {
+    TRACE_BEGIN(span);
+    osd_overlays_t overlays;
+
+    if (osd_overlays_create(&overlays, text, all_monitors) != 0)
+        return 1;
+
+    osd_overlays_map(&overlays);
+    osd_overlays_run(&overlays, duration);
+    osd_overlays_destroy(&overlays);
+
+    TRACE_END(span, "osd_run");
+    return 0;
+}
@@ -6,6 +6,10 @@
 #include <X11/Xlib.h>
 #include <X11/extensions/Xrandr.h>
 
+#ifndef OSD_LOOP_NS
+#define OSD_LOOP_NS 20000000 // event polling interval while the overlays are up
+#endif
+
 typedef struct {
     int width;
     int height;
@@ -13,9 +17,34 @@ typedef struct {
     const char *text;
 } osd_data_t;
 
+typedef struct {
+    int x;
+    int y;
+    int width;
+    int height;
+} osd_monitor_t;
+
+typedef struct {
+    int width;
+    int height;
+    cairo_surface_t *surface;
+} osd_layer_t;
+
+typedef struct {
+    osd_monitor_t *monitors;
+    int count;
+    Aosd **osds;
+    osd_layer_t *layers;
+    int layer_cnt;
+} osd_overlays_t;
+
 void osd_render(cairo_t *cr, void *user_data);
 int osd_calculate_thickness(osd_data_t *rects_data);
-int osd_get_mouse_monitor_dimension(osd_data_t *rects_data);
-int osd_run(const char *text, int duration);
+int osd_get_monitors(osd_monitor_t **monitors, int *pointer_monitor);
+int osd_overlays_create(osd_overlays_t *o, const char *text, int all_monitors);
+void osd_overlays_map(osd_overlays_t *o);
+void osd_overlays_run(osd_overlays_t *o, int duration);
+void osd_overlays_destroy(osd_overlays_t *o);
+int osd_run(const char *text, int duration, int all_monitors);
 
 #endif // OSD_H
\ No newline at end of file
@@ -0,0 +1,97 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "soak.h"
+
+// only linked into fossodoro-soak: every allocation in the process goes
+// through these wrappers so the soak run can see what the tick path keeps
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void *ptr);
+
+static unsigned long long soak_allocs;
+static unsigned long long soak_frees;
+static long long soak_live_bytes;
+
+static void *soak_count_alloc(void *ptr) {
+    if (ptr) {
+        __atomic_fetch_add(&soak_allocs, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&soak_live_bytes, (long long) malloc_usable_size(ptr), __ATOMIC_RELAXED);
+    }
+    return ptr;
+}
+
+static void soak_count_free(void *ptr) {
+    if (ptr) {
+        __atomic_fetch_add(&soak_frees, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_sub(&soak_live_bytes, (long long) malloc_usable_size(ptr), __ATOMIC_RELAXED);
+    }
+}
+
+void *malloc(size_t size) {
+    return soak_count_alloc(__libc_malloc(size));
+}
+
+void *calloc(size_t nmemb, size_t size) {
+    return soak_count_alloc(__libc_calloc(nmemb, size));
+}
+
+void *realloc(void *ptr, size_t size) {
+    if (!ptr) return malloc(size);
+    if (size == 0) {
+        free(ptr);
+        return NULL;
+    }
+    size_t old_size = malloc_usable_size(ptr);
+    void *res = __libc_realloc(ptr, size);
+    if (res) {
+        __atomic_fetch_add(&soak_live_bytes, (long long) malloc_usable_size(res) - (long long) old_size, __ATOMIC_RELAXED);
+        if (res != ptr) {
+            __atomic_fetch_add(&soak_allocs, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&soak_frees, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return res;
+}
+
+void *memalign(size_t alignment, size_t size) {
+    return soak_count_alloc(__libc_memalign(alignment, size));
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size) {
+    void *ptr = memalign(alignment, size);
+    if (!ptr) return ENOMEM;
+    *memptr = ptr;
+    return 0;
+}
+
+void free(void *ptr) {
+    soak_count_free(ptr);
+    __libc_free(ptr);
+}
+
+void soak_get_alloc_stats(soak_alloc_stats_t *stats) {
+    stats->allocs = __atomic_load_n(&soak_allocs, __ATOMIC_RELAXED);
+    stats->frees = __atomic_load_n(&soak_frees, __ATOMIC_RELAXED);
+    stats->live_bytes = __atomic_load_n(&soak_live_bytes, __ATOMIC_RELAXED);
+}
+
+long soak_get_rss_kb(void) {
+    long size, resident;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (!f) return -1;
+    if (fscanf(f, "%ld %ld", &size, &resident) != 2) resident = -1;
+    fclose(f);
+    return resident < 0 ? -1 : resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
@@ -0,0 +1,13 @@
+#ifndef FOSSODORO_SOAK_H
+#define FOSSODORO_SOAK_H
+
+typedef struct {
+    unsigned long long allocs;
+    unsigned long long frees;
+    long long live_bytes;
+} soak_alloc_stats_t;
+
+void soak_get_alloc_stats(soak_alloc_stats_t *stats);
+long soak_get_rss_kb(void);
+
+#endif // FOSSODORO_SOAK_H
@@ -1,44 +1,181 @@
-
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include "sound.h"
+#include "trace.h"
 
-void sound_play(sound_play_data_t* data) {
-    ao_device *device;
-    ao_sample_format sample_format;
-    
-    mpg123_handle *mh;
-    size_t outmemsize, done;
-    
-    unsigned char *outmemory;
-    int driver_id, channels, encoding, error, rate;
+static const char *sound_driver;
+static int sound_users;
 
+void sound_set_driver(const char* name) {
+    sound_driver = name;
+}
+
+// libao and mpg123 keep global state that is neither reference counted nor
+// thread safe, so they are set up once for the whole process
+int sound_init() {
+    if (mpg123_init() != MPG123_OK) {
+        fprintf(stderr, "Unable to initialize mpg123\n");
+        return 1;
+    }
     ao_initialize();
-    driver_id = ao_default_driver_id();
+    return 0;
+}
+
+// unloading the drivers under a playing thread would crash, give dings a moment to finish
+void sound_shutdown() {
+    for (int waited = 0; sound_pending() > 0 && waited < SOUND_SHUTDOWN_WAIT_MS; waited += 10) {
+        struct timespec ts = { 0, 10000000 };
+        nanosleep(&ts, NULL);
+    }
+    if (sound_pending() > 0) return;
+    ao_shutdown();
+    mpg123_exit();
+}
+
+// every thread that may touch libao holds a reference until it is done
+void sound_ref() {
+    __atomic_add_fetch(&sound_users, 1, __ATOMIC_RELAXED);
+}
+
+void sound_unref() {
+    __atomic_sub_fetch(&sound_users, 1, __ATOMIC_RELEASE);
+}
+
+int sound_pending() {
+    return __atomic_load_n(&sound_users, __ATOMIC_ACQUIRE);
+}
+
+static int sound_driver_id() {
+    return sound_driver ? ao_driver_id(sound_driver) : ao_default_driver_id();
+}
+
+int sound_decode(const char* audio_file, double volume, sound_sample_t* sample) {
+    mpg123_handle *mh;
+    size_t outmemsize, done, capacity;
+    int channels, encoding, error, rate;
+
+    memset(sample, 0, sizeof(sound_sample_t));
 
-    mpg123_init();
     mh = mpg123_new(NULL, &error);
+    if (!mh) return 1;
+
+    if (mpg123_open(mh, audio_file) != MPG123_OK ||
+        mpg123_getformat(mh, &rate, &channels, &encoding) != MPG123_OK) {
+        mpg123_delete(mh);
+        return 1;
+    }
+    mpg123_volume(mh, volume);
+
+    sample->format.channels = channels;
+    sample->format.bits = mpg123_encsize(encoding) * SOUND_BITS;
+    sample->format.byte_format = AO_FMT_NATIVE;
+    sample->format.rate = rate;
+    sample->format.matrix = 0;
+
+    // the dings are short, decode the whole file so playback is a single write
     outmemsize = mpg123_outblock(mh);
-    outmemory = (unsigned char*) malloc(outmemsize * sizeof(unsigned char));
-
-    mpg123_open(mh, data->audio_file);
-    mpg123_getformat(mh, &rate, &channels, &encoding);
-    mpg123_volume(mh, data->volume);
-
-    sample_format.channels = channels;
-    sample_format.bits = mpg123_encsize(encoding) * SOUND_BITS;
-    sample_format.byte_format = AO_FMT_NATIVE;
-    sample_format.rate = rate;
-    sample_format.matrix = 0;
-    
-    device = ao_open_live(driver_id, &sample_format, NULL);
-    
-    while (mpg123_read(mh, outmemory, outmemsize, &done) == MPG123_OK)
-        ao_play(device, outmemory, done);
-
-    free(outmemory);
+    capacity = outmemsize * 16;
+    sample->data = (unsigned char*) malloc(capacity);
+
+    while (sample->data) {
+        if (capacity - sample->size < outmemsize) {
+            capacity *= 2;
+            unsigned char *grown = (unsigned char*) realloc(sample->data, capacity);
+            if (!grown) {
+                free(sample->data);
+                sample->data = NULL;
+                break;
+            }
+            sample->data = grown;
+        }
+        if (mpg123_read(mh, sample->data + sample->size, outmemsize, &done) != MPG123_OK) {
+            sample->size += done;
+            break;
+        }
+        sample->size += done;
+    }
+
     mpg123_close(mh);
     mpg123_delete(mh);
-    mpg123_exit();
 
-    ao_close(device);
-    ao_shutdown();
-}
\ No newline at end of file
+    return sample->data ? 0 : 1;
+}
+
+void sound_sample_free(sound_sample_t* sample) {
+    free(sample->data);
+    sample->data = NULL;
+    sample->size = 0;
+}
+
+// every sound_open needs a matching sound_close, even when it fails
+int sound_open(const sound_play_data_t* data, sound_prepared_t* prepared) {
+    memset(prepared, 0, sizeof(sound_prepared_t));
+    int driver_id = sound_driver_id();
+
+    TRACE_BEGIN(decode_span);
+    int decoded = sound_decode(data->audio_file, data->volume, &prepared->sample);
+    TRACE_END(decode_span, "sound_play:decode");
+
+    if (decoded != 0) {
+        fprintf(stderr, "Unable to decode %s\n", data->audio_file);
+        return 1;
+    }
+
+    TRACE_BEGIN(open_span);
+    prepared->device = ao_open_live(driver_id, &prepared->sample.format, NULL);
+    TRACE_END(open_span, "sound_play:device_open");
+
+    return prepared->device ? 0 : 1;
+}
+
+void sound_play_prepared(sound_prepared_t* prepared) {
+    if (!prepared->device) return;
+
+    TRACE_BEGIN(play_span);
+    ao_play(prepared->device, (char*) prepared->sample.data, prepared->sample.size);
+    TRACE_END(play_span, "sound_play:playback");
+}
+
+void sound_close(sound_prepared_t* prepared) {
+    if (prepared->device) ao_close(prepared->device);
+    prepared->device = NULL;
+    sound_sample_free(&prepared->sample);
+}
+
+void sound_play(sound_play_data_t* data) {
+    sound_prepared_t prepared;
+
+    trace_set_thread_name("sound");
+
+    if (sound_open(data, &prepared) == 0)
+        sound_play_prepared(&prepared);
+    sound_close(&prepared);
+}
+
+static void *sound_play_thread(void *arg) {
+    sound_play_data_t *data = (sound_play_data_t*) arg;
+    sound_play(data);
+    free(data);
+    sound_unref();
+    return NULL;
+}
+
+int sound_play_async(const sound_play_data_t* data) {
+    pthread_t thread;
+    sound_play_data_t *copy = (sound_play_data_t*) malloc(sizeof(sound_play_data_t));
+    if (!copy) return 1;
+    *copy = *data;
+
+    sound_ref();
+    if (pthread_create(&thread, NULL, sound_play_thread, copy) != 0) {
+        sound_unref();
+        free(copy);
+        return 1;
+    }
+    // nobody waits for a ding, let the thread clean up after itself
+    pthread_detach(thread);
+    return 0;
+}
@@ -8,11 +8,39 @@
 #define SOUND_BITS 8
 #endif
 
+#ifndef SOUND_SHUTDOWN_WAIT_MS
+#define SOUND_SHUTDOWN_WAIT_MS 3000 // longest sound_shutdown waits for dings still playing
+#endif
+
 typedef struct {
     const char* audio_file;
     double volume;
 } sound_play_data_t;
 
+typedef struct {
+    unsigned char *data;
+    size_t size;
+    ao_sample_format format;
+} sound_sample_t;
+
+// a decoded ding with its device open, split out so it can be set up ahead of time
+typedef struct {
+    sound_sample_t sample;
+    ao_device *device;
+} sound_prepared_t;
+
+int sound_init();
+void sound_shutdown();
+void sound_ref();
+void sound_unref();
+int sound_pending();
+void sound_set_driver(const char* name);
+int sound_decode(const char* audio_file, double volume, sound_sample_t* sample);
+void sound_sample_free(sound_sample_t* sample);
 void sound_play(sound_play_data_t* data);
+int sound_play_async(const sound_play_data_t* data);
+int sound_open(const sound_play_data_t* data, sound_prepared_t* prepared);
+void sound_play_prepared(sound_prepared_t* prepared);
+void sound_close(sound_prepared_t* prepared);
 
 #endif // SOUNDDORO_SOUND_H
\ No newline at end of file
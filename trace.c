@@ -0,0 +1,160 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "trace.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct {
+    const char *name;
+    uint64_t start;
+    uint64_t end;
+} trace_event_t;
+
+typedef struct trace_ring {
+    struct trace_ring *next;
+    uint64_t head;
+    int tid;
+    int released;
+    const char *thread_name;
+    trace_event_t events[TRACE_RING_SIZE];
+} trace_ring_t;
+
+volatile int trace_enabled = 0;
+
+static char *trace_path;
+static trace_ring_t *trace_rings;
+static int trace_next_tid = 1;
+static uint64_t trace_epoch;
+static pthread_key_t trace_ring_key;
+
+static __thread trace_ring_t *thread_ring;
+
+uint64_t trace_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+static void trace_flush_atexit(void) {
+    trace_flush();
+}
+
+// the events stay for the flush, the ring is handed to the next thread with the same name
+static void trace_release_ring(void *arg) {
+    trace_ring_t *ring = (trace_ring_t*) arg;
+    __atomic_store_n(&ring->released, 1, __ATOMIC_RELEASE);
+}
+
+int trace_init(const char *path) {
+    if (!path || !*path) return 1;
+    trace_path = strdup(path);
+    trace_epoch = trace_now();
+    pthread_key_create(&trace_ring_key, trace_release_ring);
+    atexit(trace_flush_atexit);
+    trace_enabled = 1;
+    trace_set_thread_name("main");
+    return 0;
+}
+
+// sound and OSD threads come and go at every phase end, reuse the ring of an
+// exited thread with the same name so a long session keeps a bounded set
+static trace_ring_t *trace_claim_ring(const char *name) {
+    trace_ring_t *ring = __atomic_load_n(&trace_rings, __ATOMIC_ACQUIRE);
+    for (; ring; ring = ring->next) {
+        int released = 1;
+        if (!__atomic_load_n(&ring->released, __ATOMIC_ACQUIRE))
+            continue;
+        if (ring->thread_name != name &&
+            (!ring->thread_name || !name || strcmp(ring->thread_name, name) != 0))
+            continue;
+        if (__atomic_compare_exchange_n(&ring->released, &released, 0, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return ring;
+    }
+    return NULL;
+}
+
+static trace_ring_t *trace_get_ring(const char *name) {
+    if (thread_ring) return thread_ring;
+
+    trace_ring_t *ring = trace_claim_ring(name);
+    if (!ring) {
+        ring = (trace_ring_t*) calloc(1, sizeof(trace_ring_t));
+        if (!ring) return NULL;
+        ring->tid = __atomic_fetch_add(&trace_next_tid, 1, __ATOMIC_RELAXED);
+        ring->thread_name = name;
+
+        // push onto the global list, threads never take a lock to record
+        ring->next = __atomic_load_n(&trace_rings, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&trace_rings, &ring->next, ring, 1,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+            ;
+    }
+
+    pthread_setspecific(trace_ring_key, ring);
+    thread_ring = ring;
+    return ring;
+}
+
+void trace_record(const char *name, uint64_t start_ns, uint64_t end_ns) {
+    trace_ring_t *ring = trace_get_ring(NULL);
+    if (!ring) return;
+
+    // single writer per ring: fill the slot, then publish the new head
+    uint64_t head = ring->head;
+    trace_event_t *ev = &ring->events[head & (TRACE_RING_SIZE - 1)];
+    ev->name = name;
+    ev->start = start_ns;
+    ev->end = end_ns;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+void trace_set_thread_name(const char *name) {
+    if (!trace_enabled) return;
+    trace_ring_t *ring = trace_get_ring(name);
+    if (ring) ring->thread_name = name;
+}
+
+int trace_flush(void) {
+    if (!trace_enabled || !trace_path) return 1;
+
+    FILE *f = fopen(trace_path, "w");
+    if (!f) {
+        fprintf(stderr, "Unable to write trace file %s\n", trace_path);
+        return 1;
+    }
+
+    int pid = (int) getpid();
+    int first = 1;
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    trace_ring_t *ring = __atomic_load_n(&trace_rings, __ATOMIC_ACQUIRE);
+    for (; ring; ring = ring->next) {
+        if (ring->thread_name) {
+            fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",\n", pid, ring->tid, ring->thread_name);
+            first = 0;
+        }
+
+        uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        uint64_t tail = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+        for (uint64_t i = tail; i < head; i++) {
+            trace_event_t *ev = &ring->events[i & (TRACE_RING_SIZE - 1)];
+            if (!ev->name || ev->start < trace_epoch) continue;
+            fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    first ? "" : ",\n", ev->name, pid, ring->tid,
+                    (ev->start - trace_epoch) / 1000.0,
+                    (ev->end - ev->start) / 1000.0);
+            first = 0;
+        }
+    }
+
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    return 0;
+}
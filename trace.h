@@ -0,0 +1,22 @@
+#ifndef FOSSODORO_TRACE_H
+#define FOSSODORO_TRACE_H
+
+#include <stdint.h>
+
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE 16384 // events kept per thread, must be a power of two
+#endif
+
+extern volatile int trace_enabled;
+
+// span helpers, a disabled tracer costs one load and a branch
+#define TRACE_BEGIN(var)        uint64_t var = trace_enabled ? trace_now() : 0
+#define TRACE_END(var, name)    do { if (var) trace_record((name), (var), trace_now()); } while (0)
+
+int trace_init(const char *path);
+uint64_t trace_now(void);
+void trace_record(const char *name, uint64_t start_ns, uint64_t end_ns);
+void trace_set_thread_name(const char *name);
+int trace_flush(void);
+
+#endif // FOSSODORO_TRACE_H